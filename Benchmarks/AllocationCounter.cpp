@@ -0,0 +1,175 @@
+/*
+  ==============================================================================
+
+    This file contains the allocation counter used by the benchmarks, which
+    replaces the heap allocation functions for the whole benchmark application.
+
+  ==============================================================================
+*/
+
+#include "Benchmarks.h"
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+#if JUCE_MAC
+ #include <malloc/malloc.h>
+ #include <sys/mman.h>
+ #include <unistd.h>
+#endif
+
+namespace
+{
+    std::atomic<juce::int64> numAllocations { 0 };
+
+    void countAllocation()
+    {
+        numAllocations.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+#if JUCE_LINUX && defined (__GLIBC__)
+
+//==============================================================================
+// HeapBlock, Image pixels and the standard library's operator new all end up
+// in malloc, and ScopeHistory's page-aligned chunks in posix_memalign, so
+// replacing these counts every heap allocation once. glibc exports its own
+// implementations under these names to forward to.
+extern "C"
+{
+    void* __libc_malloc(std::size_t);
+    void* __libc_calloc(std::size_t, std::size_t);
+    void* __libc_realloc(void*, std::size_t);
+    void* __libc_memalign(std::size_t, std::size_t);
+    void __libc_free(void*);
+
+    // Declared noexcept, like glibc's own declarations of them
+    void* malloc(std::size_t size) noexcept                               { countAllocation(); return __libc_malloc(size); }
+    void* calloc(std::size_t count, std::size_t size) noexcept            { countAllocation(); return __libc_calloc(count, size); }
+    void* realloc(void* memory, std::size_t size) noexcept                { countAllocation(); return __libc_realloc(memory, size); }
+    void* memalign(std::size_t alignment, std::size_t size) noexcept      { countAllocation(); return __libc_memalign(alignment, size); }
+    void* aligned_alloc(std::size_t alignment, std::size_t size) noexcept { countAllocation(); return __libc_memalign(alignment, size); }
+    void free(void* memory) noexcept                                      { __libc_free(memory); }
+
+    int posix_memalign(void** memory, std::size_t alignment, std::size_t size) noexcept
+    {
+        if (alignment < sizeof(void*) || (alignment & (alignment - 1)) != 0)
+            return EINVAL;
+
+        countAllocation();
+
+        if (auto* aligned = __libc_memalign(alignment, size))
+        {
+            *memory = aligned;
+            return 0;
+        }
+
+        return ENOMEM;
+    }
+}
+
+#elif JUCE_MAC
+
+//==============================================================================
+// malloc, calloc, realloc and posix_memalign all go through the default malloc
+// zone, whose function table is patched before main() runs. Its page is
+// normally read-only.
+namespace
+{
+    malloc_zone_t originalZone;
+
+    void* zoneMalloc(malloc_zone_t* zone, std::size_t size)
+    {
+        countAllocation();
+        return originalZone.malloc(zone, size);
+    }
+
+    void* zoneCalloc(malloc_zone_t* zone, std::size_t count, std::size_t size)
+    {
+        countAllocation();
+        return originalZone.calloc(zone, count, size);
+    }
+
+    void* zoneValloc(malloc_zone_t* zone, std::size_t size)
+    {
+        countAllocation();
+        return originalZone.valloc(zone, size);
+    }
+
+    void* zoneRealloc(malloc_zone_t* zone, void* memory, std::size_t size)
+    {
+        countAllocation();
+        return originalZone.realloc(zone, memory, size);
+    }
+
+    void* zoneMemalign(malloc_zone_t* zone, std::size_t alignment, std::size_t size)
+    {
+        countAllocation();
+        return originalZone.memalign(zone, alignment, size);
+    }
+
+    struct ZonePatch
+    {
+        ZonePatch()
+        {
+            auto* zone = malloc_default_zone();
+            const auto pageSize = (std::uintptr_t) getpagesize();
+            const auto start = (std::uintptr_t) zone & ~(pageSize - 1);
+            const auto length = (std::uintptr_t) (zone + 1) - start;
+
+            if (mprotect((void*) start, length, PROT_READ | PROT_WRITE) != 0)
+                return;
+
+            originalZone = *zone;
+            zone->malloc = zoneMalloc;
+            zone->calloc = zoneCalloc;
+            zone->valloc = zoneValloc;
+            zone->realloc = zoneRealloc;
+
+            // Zones before version 5 have no memalign, and align by other means
+            if (zone->version >= 5 && zone->memalign != nullptr)
+                zone->memalign = zoneMemalign;
+
+            mprotect((void*) start, length, PROT_READ);
+        }
+    };
+
+    const ZonePatch zonePatch;
+}
+
+#else
+
+//==============================================================================
+// Without a way to intercept malloc here, only operator new is counted: every
+// object, String, Image and std::function, but not HeapBlock storage or
+// ScopeHistory's _aligned_malloc chunks.
+namespace
+{
+    void* allocate(std::size_t size)
+    {
+        countAllocation();
+
+        if (auto* memory = std::malloc(size == 0 ? 1 : size))
+            return memory;
+
+        throw std::bad_alloc();
+    }
+}
+
+void* operator new(std::size_t size)                                   { return allocate(size); }
+void* operator new[](std::size_t size)                                 { return allocate(size); }
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept   { try { return allocate(size); } catch (...) { return nullptr; } }
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept { try { return allocate(size); } catch (...) { return nullptr; } }
+void operator delete(void* memory) noexcept                            { std::free(memory); }
+void operator delete[](void* memory) noexcept                          { std::free(memory); }
+void operator delete(void* memory, std::size_t) noexcept               { std::free(memory); }
+void operator delete[](void* memory, std::size_t) noexcept             { std::free(memory); }
+
+#endif
+
+//==============================================================================
+juce::int64 Benchmarks::getNumAllocations()
+{
+    return numAllocations.load(std::memory_order_relaxed);
+}
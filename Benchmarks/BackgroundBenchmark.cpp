@@ -0,0 +1,54 @@
+/*
+  ==============================================================================
+
+    This file contains the background layer benchmark: what each display frame
+    costs before any trace is drawn, redrawn from scratch against blitted from
+    the cache.
+
+  ==============================================================================
+*/
+
+#include "Benchmarks.h"
+#include "ScopeBackground.h"
+
+//==============================================================================
+void Benchmarks::runBackgroundBenchmark()
+{
+    struct Size { const char* name; int width, height; float scale; };
+
+    // Logical editor sizes at the pixel densities the plugin meets in practice
+    const Size sizes[] = {
+        { "1080p", 1920, 1080, 1.0f },
+        { "1080p@2x", 1920, 1080, 2.0f },
+        { "4K", 3840, 2160, 1.0f },
+        { "4K@1.5x", 2560, 1440, 1.5f }
+    };
+
+    std::printf("background: us/frame, best of 5\n");
+    std::printf("%10s %12s %12s %12s\n", "size", "redrawn", "cached", "saved");
+
+    for (auto& size : sizes)
+    {
+        ScopeBackground::Layout layout;
+        layout.width = size.width;
+        layout.height = size.height;
+        layout.scale = size.scale;
+        layout.secondsPerDivision = 0.001;
+        layout.triggerY = size.height / 3;
+
+        // Stand-in for the window's backing store, in physical pixels
+        juce::Image target(juce::Image::RGB, juce::roundToInt(size.width * size.scale),
+                           juce::roundToInt(size.height * size.scale), false, juce::SoftwareImageType());
+        juce::Graphics g(target);
+        g.addTransform(juce::AffineTransform::scale(size.scale));
+
+        auto redrawnNs = measureNanoseconds(20, [&] { ScopeBackground::render(g, layout); });
+
+        ScopeBackground background;
+        background.draw(g, layout);
+        auto cachedNs = measureNanoseconds(20, [&] { background.draw(g, layout); });
+
+        std::printf("%10s %12.1f %12.1f %12.1f\n", size.name,
+                    redrawnNs * 1.0e-3, cachedNs * 1.0e-3, (redrawnNs - cachedNs) * 1.0e-3);
+    }
+}
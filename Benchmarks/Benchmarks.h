@@ -0,0 +1,77 @@
+/*
+  ==============================================================================
+
+    This file contains the entry points of the offline benchmarks.
+
+    The benchmarks are a separate JUCE console application, built with the
+    CMakeLists.txt in this folder from every file here plus the plugin's
+    Source/ files. To use the Projucer instead, create a console app with the
+    same modules as the plugin, add those files, add Source/ to the header
+    search paths and define JucePlugin_Name, which the processor reports.
+
+    Run with --json <file> to also write the processBlock and editor results
+    as JSON, one object per measurement, for regression tracking.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <cstdio>
+
+//==============================================================================
+namespace Benchmarks
+{
+    /** Returns the nanoseconds per call of body, taking the best of a few rounds
+        so that scheduler noise does not dominate short measurements.
+    */
+    template <typename Body>
+    double measureNanoseconds(int iterations, Body&& body)
+    {
+        double best = std::numeric_limits<double>::max();
+
+        for (int round = 0; round < 5; ++round)
+        {
+            auto start = juce::Time::getHighResolutionTicks();
+
+            for (int i = 0; i < iterations; ++i)
+                body();
+
+            auto elapsed = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - start);
+            best = juce::jmin(best, elapsed * 1.0e9 / iterations);
+        }
+
+        return best;
+    }
+
+    /** Number of heap allocations so far, from any thread. On Linux and macOS
+        that is malloc, calloc, realloc and the aligned allocators, which
+        between them cover operator new and ScopeHistory's chunks. Elsewhere
+        only operator new is counted, which misses HeapBlock storage and the
+        chunks copied on write during a frame. See AllocationCounter.cpp.
+    */
+    juce::int64 getNumAllocations();
+
+    /** Measurements as objects of named values, ready for JSON::toString(). */
+    using Results = juce::Array<juce::var>;
+
+    /** processBlock capture path: old per-sample loop against CaptureFifo. */
+    void runCaptureBenchmark();
+
+    /** Display background: redrawn every frame against the cached layer. */
+    void runBackgroundBenchmark();
+
+    /** Trace drawing: Path stroking against TraceRasterizer. */
+    void runTraceBenchmark();
+
+    /** The whole processor: ns/sample of processBlock across sample rates,
+        block sizes and channel counts.
+    */
+    void runProcessBlockBenchmark(Results& results);
+
+    /** The whole display: OscilloscopeComponent rendered offscreen in each mode,
+        with frame time percentiles and allocations per frame.
+    */
+    void runEditorBenchmark(Results& results);
+}
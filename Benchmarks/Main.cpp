@@ -0,0 +1,56 @@
+/*
+  ==============================================================================
+
+    This file contains the entry point of the offline benchmarks.
+
+  ==============================================================================
+*/
+
+#include "Benchmarks.h"
+
+//==============================================================================
+int main(int argc, char* argv[])
+{
+    // Text rendering needs the GUI side of JUCE initialised
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    juce::StringArray arguments(argv + 1, argc - 1);
+    auto jsonIndex = arguments.indexOf("--json");
+    juce::File jsonFile;
+
+    if (jsonIndex >= 0)
+    {
+        if (jsonIndex + 1 >= arguments.size())
+        {
+            std::printf("usage: %s [--json <file>]\n", argv[0]);
+            return 1;
+        }
+
+        jsonFile = juce::File::getCurrentWorkingDirectory().getChildFile(arguments[jsonIndex + 1]);
+    }
+
+    Benchmarks::runCaptureBenchmark();
+    Benchmarks::runBackgroundBenchmark();
+    Benchmarks::runTraceBenchmark();
+
+    Benchmarks::Results results;
+    Benchmarks::runProcessBlockBenchmark(results);
+    Benchmarks::runEditorBenchmark(results);
+
+    if (jsonFile != juce::File())
+    {
+        auto* report = new juce::DynamicObject();
+        report->setProperty("version", juce::SystemStats::getJUCEVersion());
+        report->setProperty("operatingSystem", juce::SystemStats::getOperatingSystemName());
+        report->setProperty("cpu", juce::SystemStats::getCpuModel());
+        report->setProperty("results", results);
+
+        if (!jsonFile.replaceWithText(juce::JSON::toString(juce::var(report))))
+        {
+            std::printf("could not write %s\n", jsonFile.getFullPathName().toRawUTF8());
+            return 1;
+        }
+    }
+
+    return 0;
+}
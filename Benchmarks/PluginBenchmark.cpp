@@ -0,0 +1,243 @@
+/*
+  ==============================================================================
+
+    This file contains the whole-plugin benchmarks: the processor's audio
+    callback and the editor's display, driven offscreen with synthetic audio.
+
+  ==============================================================================
+*/
+
+#include "Benchmarks.h"
+#include "PluginProcessor.h"
+#include "PluginEditor.h"
+
+namespace
+{
+    // A sine per channel at a different pitch with a little noise on top, so
+    // the trigger fires and every display mode has something to show
+    struct TestSignal
+    {
+        explicit TestSignal(double sampleRate) : sampleRate(sampleRate) {}
+
+        void render(juce::AudioBuffer<float>& buffer)
+        {
+            for (int channel = 0; channel < buffer.getNumChannels(); ++channel)
+            {
+                auto* samples = buffer.getWritePointer(channel);
+                auto increment = juce::MathConstants<double>::twoPi * 220.0 * (channel + 1) / sampleRate;
+
+                for (int i = 0; i < buffer.getNumSamples(); ++i)
+                    samples[i] = 0.5f * (float) std::sin((position + i) * increment) + 0.01f * (random.nextFloat() - 0.5f);
+            }
+
+            position += buffer.getNumSamples();
+        }
+
+        double sampleRate;
+        juce::int64 position = 0;
+        juce::Random random { 1 };
+    };
+
+    // What the editor's render thread does between frames, minus the drawing
+    void drain(SCOPESCT002AudioProcessor& processor)
+    {
+        const juce::ScopedLock sl(processor.getCaptureLock());
+        processor.drainCapture();
+
+        TriggerEvent event;
+
+        while (processor.getTriggerEngine().pop(event))
+        {
+        }
+    }
+
+    double getPercentile(juce::Array<double> values, double percentile)
+    {
+        if (values.isEmpty())
+            return 0.0;
+
+        values.sort();
+        return values[juce::jlimit(0, values.size() - 1, (int) std::ceil(percentile * values.size()) - 1)];
+    }
+}
+
+//==============================================================================
+void Benchmarks::runProcessBlockBenchmark(Results& results)
+{
+    const double sampleRates[] = { 44100.0, 48000.0, 96000.0, 192000.0 };
+    const int blockSizes[] = { 32, 128, 512, 2048 };
+    const int channelCounts[] = { 1, 2, 8 };
+
+    std::printf("processBlock: ns/sample per channel, best of 5\n");
+    std::printf("%8s %8s %9s %12s %12s\n", "rate", "block", "channels", "ns/sample", "allocations");
+
+    for (auto sampleRate : sampleRates)
+    {
+        for (auto blockSize : blockSizes)
+        {
+            for (auto numChannels : channelCounts)
+            {
+                SCOPESCT002AudioProcessor processor;
+                processor.setPlayConfigDetails(numChannels, numChannels, sampleRate, blockSize);
+
+                if (processor.getTotalNumInputChannels() != numChannels)
+                    continue;
+
+                processor.prepareToPlay(sampleRate, blockSize);
+
+                // The processor passes audio through untouched, so one block can be reused
+                juce::AudioBuffer<float> buffer(numChannels, blockSize);
+                juce::MidiBuffer midi;
+                TestSignal(sampleRate).render(buffer);
+
+                // Drained, untimed, at half the FIFO so that no block is dropped
+                const int blocksPerDrain = juce::jmax(1, juce::jmax(blockSize * 8, juce::roundToInt(sampleRate * 0.25)) / 2 / blockSize);
+                const int numBlocks = juce::jmax(blocksPerDrain, juce::roundToInt(sampleRate * 0.5) / blockSize);
+
+                double bestNs = std::numeric_limits<double>::max();
+                juce::int64 allocations = 0;
+
+                for (int round = 0; round < 5; ++round)
+                {
+                    juce::int64 ticks = 0;
+
+                    for (int done = 0; done < numBlocks; done += blocksPerDrain)
+                    {
+                        const auto count = juce::jmin(blocksPerDrain, numBlocks - done);
+                        const auto allocationsBefore = getNumAllocations();
+                        const auto start = juce::Time::getHighResolutionTicks();
+
+                        for (int i = 0; i < count; ++i)
+                            processor.processBlock(buffer, midi);
+
+                        ticks += juce::Time::getHighResolutionTicks() - start;
+                        allocations += getNumAllocations() - allocationsBefore;
+                        drain(processor);
+                    }
+
+                    auto seconds = juce::Time::highResolutionTicksToSeconds(ticks);
+                    bestNs = juce::jmin(bestNs, seconds * 1.0e9 / ((double) numBlocks * blockSize * numChannels));
+                }
+
+                processor.releaseResources();
+
+                std::printf("%8.0f %8d %9d %12.3f %12lld\n", sampleRate, blockSize, numChannels, bestNs, (long long) allocations);
+
+                auto* result = new juce::DynamicObject();
+                result->setProperty("benchmark", "processBlock");
+                result->setProperty("sampleRate", sampleRate);
+                result->setProperty("blockSize", blockSize);
+                result->setProperty("channels", numChannels);
+                result->setProperty("nsPerSample", bestNs);
+                result->setProperty("allocations", allocations);
+                results.add(juce::var(result));
+            }
+        }
+    }
+}
+
+//==============================================================================
+void Benchmarks::runEditorBenchmark(Results& results)
+{
+    struct Mode { const char* name; ScopeRenderer::DisplayMode mode; double persistenceSeconds; };
+    struct Size { const char* name; int width, height; float scale; };
+
+    const Mode modes[] = {
+        { "scope", ScopeRenderer::DisplayMode::scope, 0.0 },
+        { "phosphor", ScopeRenderer::DisplayMode::scope, 0.5 },
+        { "spectrum", ScopeRenderer::DisplayMode::spectrum, 0.0 },
+        { "spectrogram", ScopeRenderer::DisplayMode::spectrogram, 0.0 },
+        { "goniometer", ScopeRenderer::DisplayMode::goniometer, 0.0 }
+    };
+
+    const Size sizes[] = {
+        { "800x600", 800, 600, 1.0f },
+        { "800x600@2x", 800, 600, 2.0f },
+        { "1920x1080", 1920, 1080, 1.0f }
+    };
+
+    // A 60 Hz display fed by a host calling back with 400-sample blocks at 48 kHz
+    const double sampleRate = 48000.0;
+    const int blockSize = 400, blocksPerFrame = 2;
+    const int warmUpFrames = 30, numFrames = 300;
+
+    std::printf("editor: ms/frame offscreen, stereo at 48 kHz, %d frames\n", numFrames);
+    std::printf("%12s %12s %8s %8s %8s %8s %10s %12s\n", "mode", "size", "p50", "p90", "p99", "max", "snapshot", "allocations");
+
+    for (auto& mode : modes)
+    {
+        for (auto& size : sizes)
+        {
+            SCOPESCT002AudioProcessor processor;
+            processor.setPlayConfigDetails(2, 2, sampleRate, blockSize);
+            processor.prepareToPlay(sampleRate, blockSize);
+
+            juce::AudioBuffer<float> buffer(2, blockSize);
+            juce::MidiBuffer midi;
+            TestSignal signal(sampleRate);
+
+            // Never put on screen: the frames are pulled with renderFrameAndWait()
+            // and composited with a snapshot, as paint() would on the message thread
+            OscilloscopeComponent scope(processor);
+            scope.setDisplayMode(mode.mode);
+            scope.setPersistence(mode.persistenceSeconds);
+            scope.setBounds(0, 0, size.width, size.height);
+
+            juce::Array<double> renderTimes, snapshotTimes;
+            juce::int64 allocations = 0;
+            int numMissed = 0;
+
+            for (int frame = 0; frame < warmUpFrames + numFrames; ++frame)
+            {
+                for (int i = 0; i < blocksPerFrame; ++i)
+                {
+                    signal.render(buffer);
+                    processor.processBlock(buffer, midi);
+                }
+
+                const auto allocationsBefore = getNumAllocations();
+                const auto start = juce::Time::getHighResolutionTicks();
+                const auto rendered = scope.renderFrameAndWait(1000);
+                const auto renderEnd = juce::Time::getHighResolutionTicks();
+                const auto renderAllocations = getNumAllocations() - allocationsBefore;
+
+                // The first frames pick up the snapshot's pixel scale
+                scope.createComponentSnapshot(scope.getLocalBounds(), true, size.scale);
+                const auto snapshotEnd = juce::Time::getHighResolutionTicks();
+
+                if (frame < warmUpFrames)
+                    continue;
+
+                if (!rendered)
+                    ++numMissed;
+
+                renderTimes.add(juce::Time::highResolutionTicksToSeconds(renderEnd - start) * 1.0e3);
+                snapshotTimes.add(juce::Time::highResolutionTicksToSeconds(snapshotEnd - renderEnd) * 1.0e3);
+                allocations += renderAllocations;
+            }
+
+            const auto allocationsPerFrame = allocations / (double) numFrames;
+
+            std::printf("%12s %12s %8.3f %8.3f %8.3f %8.3f %10.3f %12.2f%s\n", mode.name, size.name,
+                        getPercentile(renderTimes, 0.5), getPercentile(renderTimes, 0.9), getPercentile(renderTimes, 0.99),
+                        getPercentile(renderTimes, 1.0), getPercentile(snapshotTimes, 0.5), allocationsPerFrame,
+                        numMissed > 0 ? " (frames missed)" : "");
+
+            auto* result = new juce::DynamicObject();
+            result->setProperty("benchmark", "editor");
+            result->setProperty("mode", mode.name);
+            result->setProperty("width", size.width);
+            result->setProperty("height", size.height);
+            result->setProperty("scale", size.scale);
+            result->setProperty("frames", numFrames);
+            result->setProperty("framesMissed", numMissed);
+            result->setProperty("renderMsP50", getPercentile(renderTimes, 0.5));
+            result->setProperty("renderMsP90", getPercentile(renderTimes, 0.9));
+            result->setProperty("renderMsP99", getPercentile(renderTimes, 0.99));
+            result->setProperty("renderMsMax", getPercentile(renderTimes, 1.0));
+            result->setProperty("snapshotMsP50", getPercentile(snapshotTimes, 0.5));
+            result->setProperty("allocationsPerFrame", allocationsPerFrame);
+            results.add(juce::var(result));
+        }
+    }
+}
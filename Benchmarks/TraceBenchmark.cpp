@@ -0,0 +1,88 @@
+/*
+  ==============================================================================
+
+    This file contains the trace drawing benchmark: a min/max envelope stroked
+    as a juce::Path against the same envelope drawn by TraceRasterizer.
+
+  ==============================================================================
+*/
+
+#include "Benchmarks.h"
+#include "TraceRasterizer.h"
+
+//==============================================================================
+void Benchmarks::runTraceBenchmark()
+{
+    struct Size { const char* name; int width, height; };
+
+    const Size sizes[] = {
+        { "800x600", 800, 600 },
+        { "3840x2160", 3840, 2160 }
+    };
+
+    std::printf("trace: us/frame for two min/max traces, best of 5\n");
+    std::printf("%10s %12s %12s %8s\n", "size", "Path", "rasterizer", "speedup");
+
+    for (auto& size : sizes)
+    {
+        // Per-column extremes of a noisy sine, as the pyramid would return them
+        juce::HeapBlock<float> tops((size_t) size.width), bottoms((size_t) size.width);
+        juce::Random random(1);
+
+        for (int column = 0; column < size.width; ++column)
+        {
+            auto centre = size.height * (0.5f + 0.3f * std::sin((float) column * 0.02f));
+            auto spread = size.height * 0.05f * random.nextFloat();
+            tops[column] = centre - spread;
+            bottoms[column] = centre + spread;
+        }
+
+        // Stand-in for the window's backing store
+        juce::Image target(juce::Image::RGB, size.width, size.height, true, juce::SoftwareImageType());
+        juce::Graphics g(target);
+
+        juce::Path path;
+        auto pathNs = measureNanoseconds(10, [&]
+        {
+            for (auto colour : { juce::Colours::cyan, juce::Colours::yellow })
+            {
+                path.clear();
+                path.startNewSubPath(0.0f, tops[0]);
+                path.lineTo(0.0f, bottoms[0]);
+
+                for (int column = 1; column < size.width; ++column)
+                {
+                    path.lineTo((float) column, tops[column]);
+                    path.lineTo((float) column, bottoms[column]);
+                }
+
+                g.setColour(colour);
+                g.strokePath(path, juce::PathStrokeType(1.0f));
+            }
+        });
+
+        TraceColumns trace;
+        TraceRasterizer rasterizer;
+        trace.setSize(size.width, size.height);
+        rasterizer.setSize(size.width, size.height);
+        auto rasterNs = measureNanoseconds(10, [&]
+        {
+            rasterizer.clear();
+
+            for (auto colour : { juce::Colours::cyan, juce::Colours::yellow })
+            {
+                trace.clear();
+
+                for (int column = 0; column < size.width; ++column)
+                    trace.addSpan(column, tops[column], bottoms[column]);
+
+                rasterizer.draw(trace, colour);
+            }
+
+            g.drawImageAt(rasterizer.getImage(), 0, 0);
+        });
+
+        std::printf("%10s %12.1f %12.1f %7.1fx\n", size.name,
+                    pathNs * 1.0e-3, rasterNs * 1.0e-3, pathNs / juce::jmax(rasterNs, 1.0e-9));
+    }
+}
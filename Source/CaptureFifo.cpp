@@ -0,0 +1,96 @@
+/*
+  ==============================================================================
+
+    This file contains the lock-free channel that carries captured audio from
+    the audio thread to the oscilloscope display.
+
+  ==============================================================================
+*/
+
+#include "CaptureFifo.h"
+
+//==============================================================================
+void CaptureFifo::prepare(int numChannels, int capacityInSamples, int maxBlocks)
+{
+    jassert(numChannels <= maxChannels);
+
+    capacity = juce::nextPowerOfTwo(juce::jmax(capacityInSamples, 1));
+    sampleMask = capacity - 1;
+
+    headerCapacity = juce::nextPowerOfTwo(juce::jmax(maxBlocks, 1));
+    headerMask = headerCapacity - 1;
+
+    storage.setSize(juce::jmax(numChannels, 1), capacity);
+    headers.calloc((size_t) headerCapacity);
+
+    reset();
+}
+
+void CaptureFifo::reset()
+{
+    storage.clear();
+
+    producer.blocksWritten.store(0);
+    producer.droppedBlocks.store(0);
+    producer.samplesWritten = 0;
+    producer.position = 0;
+    producer.sequence = 0;
+
+    consumer.blocksRead.store(0);
+    consumer.samplesRead.store(0);
+}
+
+//==============================================================================
+bool CaptureFifo::push(const juce::AudioBuffer<float>& source, int numChannels, int numSamples, juce::uint64 channelMask,
+                       const MusicalPosition& musical)
+{
+    const auto sequence = producer.sequence++;
+    const auto position = producer.position;
+    producer.position += numSamples;
+
+    const auto blocksWritten = producer.blocksWritten.load(std::memory_order_relaxed);
+    const auto samplesInUse = producer.samplesWritten - consumer.samplesRead.load(std::memory_order_acquire);
+    const auto blocksInUse = blocksWritten - consumer.blocksRead.load(std::memory_order_acquire);
+
+    if (numSamples > capacity - samplesInUse || blocksInUse >= headerCapacity)
+    {
+        producer.droppedBlocks.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    // Copy as at most two contiguous runs: up to the end of the ring, then from its start
+    const auto ringStart = (int) (producer.samplesWritten & sampleMask);
+    const auto firstRun = juce::jmin(numSamples, capacity - ringStart);
+    const auto secondRun = numSamples - firstRun;
+
+    numChannels = juce::jmin(numChannels, storage.getNumChannels(), source.getNumChannels());
+    channelMask &= getAllChannelsMask(storage.getNumChannels());
+
+    for (int channel = 0; channel < storage.getNumChannels(); ++channel)
+    {
+        // Disabled channels cost nothing, however many there are
+        if ((channelMask & getChannelBit(channel)) == 0)
+            continue;
+
+        auto* ring = storage.getWritePointer(channel);
+
+        if (channel < numChannels)
+        {
+            auto* input = source.getReadPointer(channel);
+            juce::FloatVectorOperations::copy(ring + ringStart, input, firstRun);
+            juce::FloatVectorOperations::copy(ring, input + firstRun, secondRun);
+        }
+        else
+        {
+            juce::FloatVectorOperations::clear(ring + ringStart, firstRun);
+            juce::FloatVectorOperations::clear(ring, secondRun);
+        }
+    }
+
+    headers[(size_t) (blocksWritten & headerMask)] = { sequence, position, numSamples, channelMask, musical };
+    producer.samplesWritten += numSamples;
+
+    // Publishing the block count is what hands the samples and header over
+    producer.blocksWritten.store(blocksWritten + 1, std::memory_order_release);
+    return true;
+}
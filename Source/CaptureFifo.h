@@ -0,0 +1,169 @@
+/*
+  ==============================================================================
+
+    This file contains the lock-free channel that carries captured audio from
+    the audio thread to the oscilloscope display.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+    Wait-free single-producer / single-consumer capture channel.
+
+    The audio thread publishes each processBlock() as one sequence-numbered block
+    with push(). The consumer drains all published blocks with read() and copies
+    them into its own storage, so it never looks at memory the producer could be
+    writing. If the consumer falls behind, push() drops the whole block and
+    counts it instead of waiting.
+*/
+class CaptureFifo
+{
+public:
+    /** Where a block sits in the host's musical time, from its play head. */
+    struct MusicalPosition
+    {
+        double ppq = 0.0;            // quarter notes at the block's first sample
+        double bpm = 0.0;
+        double barStartPpq = 0.0;    // quarter notes at the start of the bar the block is in
+        int numerator = 4, denominator = 4;
+        bool isValid = false;        // false when the host gave no tempo or position
+        bool isPlaying = false;
+
+        double getQuartersPerBar() const { return numerator * 4.0 / juce::jmax(1, denominator); }
+    };
+
+    /** Describes one published block. */
+    struct BlockHeader
+    {
+        juce::uint64 sequence = 0;   // push() counter, dropped blocks included
+        juce::int64 position = 0;    // capture timeline position of the first sample
+        int numSamples = 0;
+        juce::uint64 channelMask = 0; // channels whose samples were published
+        MusicalPosition musical;
+    };
+
+    /** A published block as seen by the consumer inside read(). Where the block
+        wraps around the end of the ring, each channel comes in two runs.
+    */
+    struct BlockView
+    {
+        const CaptureFifo& fifo;
+        BlockHeader header;
+        int ringStart;
+
+        int getNumChannels() const { return fifo.storage.getNumChannels(); }
+        bool isChannelPublished(int channel) const { return (header.channelMask & getChannelBit(channel)) != 0; }
+
+        const float* getFirstRun(int channel) const { return fifo.storage.getReadPointer(channel, ringStart); }
+        int getFirstRunLength() const { return juce::jmin(header.numSamples, fifo.capacity - ringStart); }
+
+        const float* getSecondRun(int channel) const { return fifo.storage.getReadPointer(channel); }
+        int getSecondRunLength() const { return header.numSamples - getFirstRunLength(); }
+    };
+
+    /** Channel masks are 64 bits wide, which is enough for 7th order ambisonics. */
+    static constexpr int maxChannels = 64;
+    static juce::uint64 getChannelBit(int channel) { return (juce::uint64) 1 << channel; }
+    static juce::uint64 getAllChannelsMask(int numChannels) { return numChannels >= maxChannels ? ~(juce::uint64) 0 : getChannelBit(numChannels) - 1; }
+
+    CaptureFifo() = default;
+
+    /** Allocates the ring. Neither side may be running while this is called.
+        Both sizes are rounded up to powers of two.
+    */
+    void prepare(int numChannels, int capacityInSamples, int maxBlocks);
+
+    /** Empties the channel. Neither side may be running while this is called. */
+    void reset();
+
+    int getNumChannels() const { return storage.getNumChannels(); }
+    int getCapacity() const { return capacity; }
+
+    //==============================================================================
+    /** Producer: publishes numSamples from the first numChannels of source.
+        Channels beyond numChannels are published as silence. Channels missing
+        from channelMask are not touched at all, and the block's header says so.
+        Returns false if the block had to be dropped because the consumer has not
+        freed enough space.
+        The block is tagged with its musical position, if the host gave one.
+    */
+    bool push(const juce::AudioBuffer<float>& source, int numChannels, int numSamples,
+              juce::uint64 channelMask, const MusicalPosition& musical);
+
+    bool push(const juce::AudioBuffer<float>& source, int numChannels, int numSamples,
+              juce::uint64 channelMask = ~(juce::uint64) 0)
+    {
+        return push(source, numChannels, numSamples, channelMask, MusicalPosition());
+    }
+
+    /** Producer: the timeline position the next pushed block will start at. */
+    juce::int64 getNextPosition() const { return producer.position; }
+
+    //==============================================================================
+    /** Consumer: calls callback (const BlockView&) for every block published since
+        the last call, oldest first, then releases their space to the producer.
+        Returns the number of blocks read.
+    */
+    template <typename Callback>
+    int read(Callback&& callback)
+    {
+        const auto published = producer.blocksWritten.load(std::memory_order_acquire);
+        auto block = consumer.blocksRead.load(std::memory_order_relaxed);
+        auto samplePosition = consumer.samplesRead.load(std::memory_order_relaxed);
+        const auto firstBlock = block;
+
+        for (; block < published; ++block)
+        {
+            const BlockView view { *this, headers[(size_t) (block & headerMask)], (int) (samplePosition & sampleMask) };
+            callback(view);
+            samplePosition += view.header.numSamples;
+        }
+
+        consumer.samplesRead.store(samplePosition, std::memory_order_release);
+        consumer.blocksRead.store(block, std::memory_order_release);
+        return (int) (block - firstBlock);
+    }
+
+    /** Consumer: throws away everything published so far without reading it. */
+    void discardAll()
+    {
+        read([] (const BlockView&) {});
+    }
+
+    /** Number of blocks the producer had to drop since prepare(). Any thread. */
+    juce::uint64 getNumDroppedBlocks() const { return producer.droppedBlocks.load(std::memory_order_relaxed); }
+
+private:
+    //==============================================================================
+    juce::AudioBuffer<float> storage;
+    juce::HeapBlock<BlockHeader> headers;
+    int capacity = 0, sampleMask = 0;
+    juce::int64 headerCapacity = 0, headerMask = 0;
+
+    // Each side's indices live on their own cache line, so the audio thread and
+    // the consumer only ever contend on the line they actually need to read.
+    struct alignas(64) ProducerState
+    {
+        std::atomic<juce::int64> blocksWritten { 0 };
+        std::atomic<juce::uint64> droppedBlocks { 0 };
+        juce::int64 samplesWritten = 0;
+        juce::int64 position = 0;
+        juce::uint64 sequence = 0;
+    };
+
+    struct alignas(64) ConsumerState
+    {
+        std::atomic<juce::int64> blocksRead { 0 };
+        std::atomic<juce::int64> samplesRead { 0 };
+    };
+
+    ProducerState producer;
+    ConsumerState consumer;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(CaptureFifo)
+};
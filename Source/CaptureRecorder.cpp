@@ -0,0 +1,221 @@
+/*
+  ==============================================================================
+
+    This file contains the capture recorder, which streams what the scope sees
+    to a WAV or FLAC file for later inspection.
+
+  ==============================================================================
+*/
+
+#include "CaptureRecorder.h"
+
+//==============================================================================
+CaptureRecorder::CaptureRecorder()
+{
+}
+
+CaptureRecorder::~CaptureRecorder()
+{
+    stop();
+    writerThread.stopThread(2000);
+}
+
+//==============================================================================
+juce::Result CaptureRecorder::start(const juce::File& fileToWrite, const Settings& newSettings, double sampleRate, int numChannelsToWrite)
+{
+    stop();
+
+    // The recording just stopped is being replaced, not ended
+    cancelPendingUpdate();
+
+    if (sampleRate <= 0.0 || numChannelsToWrite <= 0)
+        return juce::Result::fail("Nothing is being captured");
+
+    std::unique_ptr<juce::AudioFormat> format;
+
+    if (newSettings.format == Format::flac)
+        format = std::make_unique<juce::FlacAudioFormat>();
+    else
+        format = std::make_unique<juce::WavAudioFormat>();
+
+    if (!fileToWrite.getParentDirectory().createDirectory())
+        return juce::Result::fail("Couldn't create " + fileToWrite.getParentDirectory().getFullPathName());
+
+    fileToWrite.deleteFile();
+    std::unique_ptr<juce::FileOutputStream> stream(fileToWrite.createOutputStream());
+
+    if (stream == nullptr)
+        return juce::Result::fail("Couldn't open " + fileToWrite.getFullPathName());
+
+    // FLAC stops at 24 bits, and at 8 channels
+    auto bitsPerSample = newSettings.format == Format::flac ? juce::jmin(24, newSettings.bitsPerSample) : newSettings.bitsPerSample;
+    std::unique_ptr<juce::AudioFormatWriter> formatWriter(format->createWriterFor(stream.get(), sampleRate, (unsigned int) numChannelsToWrite,
+                                                                                  bitsPerSample, {}, 0));
+
+    if (formatWriter == nullptr)
+        return juce::Result::fail(format->getFormatName() + " can't hold " + juce::String(numChannelsToWrite) + " channels of "
+                                  + juce::String(bitsPerSample) + "-bit audio at " + juce::String(sampleRate) + " Hz");
+
+    stream.release(); // now the writer's
+
+    writerThread.startThread();
+    auto threadedWriter = std::make_unique<juce::AudioFormatWriter::ThreadedWriter>(formatWriter.release(), writerThread,
+                                                                                     juce::roundToInt(sampleRate * bufferSeconds));
+
+    // Everything the audio thread will use is allocated here, then swapped in
+    auto numPreTriggerSamples = newSettings.mode == Mode::triggered
+                              ? juce::roundToInt(sampleRate * juce::jlimit(0.0, maxPreTriggerSeconds, newSettings.preTriggerSeconds))
+                              : 0;
+    juce::AudioBuffer<float> ring(numChannelsToWrite, juce::jmax(1, numPreTriggerSamples));
+    juce::HeapBlock<const float*> pointers((size_t) numChannelsToWrite);
+
+    {
+        const juce::SpinLock::ScopedLockType lock(writerLock);
+        writer = std::move(threadedWriter);
+        settings = newSettings;
+        numChannels = numChannelsToWrite;
+        std::swap(channelPointers, pointers);
+        std::swap(preTrigger, ring);
+        preTriggerSamples = numPreTriggerSamples;
+        preTriggerWrite = preTriggerFilled = 0;
+        postTriggerRemaining = (juce::int64) (sampleRate * juce::jmax(0.0, newSettings.postTriggerSeconds));
+        state.store((int) (settings.mode == Mode::triggered ? State::waitingForTrigger : State::recording));
+    }
+
+    file = fileToWrite;
+    startTimer(100);
+    return juce::Result::ok();
+}
+
+void CaptureRecorder::stop()
+{
+    stopTimer();
+    std::unique_ptr<juce::AudioFormatWriter::ThreadedWriter> finishedWriter;
+
+    {
+        const juce::SpinLock::ScopedLockType lock(writerLock);
+        std::swap(finishedWriter, writer);
+        state.store((int) State::idle);
+    }
+
+    // Deleting it writes out whatever is still buffered and closes the file
+    if (finishedWriter != nullptr)
+    {
+        finishedWriter.reset();
+        triggerAsyncUpdate();
+    }
+}
+
+void CaptureRecorder::timerCallback()
+{
+    if (getState() == State::finished)
+        stop();
+}
+
+void CaptureRecorder::handleAsyncUpdate()
+{
+    // A recording started since has nothing to report yet
+    if (!isRecording() && onFinished != nullptr)
+        onFinished();
+}
+
+//==============================================================================
+void CaptureRecorder::process(const juce::AudioBuffer<float>& buffer, int numSamples, int triggerIndex)
+{
+    // One relaxed load when nothing is being recorded
+    const auto current = getState();
+
+    if (current == State::idle || current == State::finished || numSamples <= 0)
+        return;
+
+    // Losing the race with start() or stop() only loses this block
+    const juce::SpinLock::ScopedTryLockType lock(writerLock);
+
+    if (!lock.isLocked() || writer == nullptr || buffer.getNumChannels() < numChannels)
+        return;
+
+    if (settings.mode == Mode::continuous)
+    {
+        write(buffer, 0, numSamples);
+        return;
+    }
+
+    auto postTriggerStart = 0;
+
+    if (current == State::waitingForTrigger)
+    {
+        if (triggerIndex < 0)
+        {
+            pushPreTrigger(buffer, 0, numSamples);
+            return;
+        }
+
+        // The pre-trigger samples come from the ring and then from this block
+        postTriggerStart = juce::jmin(triggerIndex, numSamples);
+        auto fromBlock = juce::jmin(postTriggerStart, preTriggerSamples);
+        writePreTrigger(juce::jmin(preTriggerFilled, preTriggerSamples - fromBlock));
+        write(buffer, postTriggerStart - fromBlock, fromBlock);
+        state.store((int) State::recording);
+    }
+
+    auto numPostTrigger = (int) juce::jmin((juce::int64) (numSamples - postTriggerStart), postTriggerRemaining);
+    write(buffer, postTriggerStart, numPostTrigger);
+    postTriggerRemaining -= numPostTrigger;
+
+    if (postTriggerRemaining <= 0)
+        state.store((int) State::finished);
+}
+
+void CaptureRecorder::write(const juce::AudioBuffer<float>& source, int startSample, int numSamples)
+{
+    if (numSamples <= 0)
+        return;
+
+    for (int channel = 0; channel < numChannels; ++channel)
+        channelPointers[channel] = source.getReadPointer(channel, startSample);
+
+    // The writer takes all of it or none of it
+    if (writer->write(channelPointers.get(), numSamples))
+        samplesRecorded.add((juce::uint64) numSamples);
+    else
+        samplesDropped.add((juce::uint64) numSamples);
+}
+
+void CaptureRecorder::writePreTrigger(int numSamples)
+{
+    if (numSamples <= 0)
+        return;
+
+    // The newest numSamples, which may wrap round the end of the ring
+    auto start = (preTriggerWrite - numSamples + preTriggerSamples) % preTriggerSamples;
+    auto firstRun = juce::jmin(numSamples, preTriggerSamples - start);
+
+    write(preTrigger, start, firstRun);
+    write(preTrigger, 0, numSamples - firstRun);
+}
+
+void CaptureRecorder::pushPreTrigger(const juce::AudioBuffer<float>& source, int startSample, int numSamples)
+{
+    if (preTriggerSamples <= 0)
+        return;
+
+    // Only the newest samples can matter
+    if (numSamples > preTriggerSamples)
+    {
+        startSample += numSamples - preTriggerSamples;
+        numSamples = preTriggerSamples;
+    }
+
+    auto firstRun = juce::jmin(numSamples, preTriggerSamples - preTriggerWrite);
+
+    for (int channel = 0; channel < numChannels; ++channel)
+    {
+        juce::FloatVectorOperations::copy(preTrigger.getWritePointer(channel, preTriggerWrite),
+                                          source.getReadPointer(channel, startSample), firstRun);
+        juce::FloatVectorOperations::copy(preTrigger.getWritePointer(channel),
+                                          source.getReadPointer(channel, startSample) + firstRun, numSamples - firstRun);
+    }
+
+    preTriggerWrite = (preTriggerWrite + numSamples) % preTriggerSamples;
+    preTriggerFilled = juce::jmin(preTriggerSamples, preTriggerFilled + numSamples);
+}
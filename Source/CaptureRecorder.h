@@ -0,0 +1,128 @@
+/*
+  ==============================================================================
+
+    This file contains the capture recorder, which streams what the scope sees
+    to a WAV or FLAC file for later inspection.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "PerformanceCounters.h"
+
+//==============================================================================
+/**
+    Records the captured channels to disk, continuously or around one trigger.
+
+    The audio thread only copies each block into the lock-free FIFO of an
+    AudioFormatWriter::ThreadedWriter; encoding and disk writes happen on the
+    recorder's own background thread. If the disk falls so far behind that the
+    FIFO is full, the block is dropped and counted rather than waited for, so
+    a slow disk shows up as a gap in the file and in the counters, never as a
+    glitch in the audio.
+
+    In triggered mode the audio thread keeps a short ring of pre-trigger audio.
+    The first trigger the TriggerEngine accepts after start() writes that ring,
+    then the following post-trigger samples, and the recording finishes by
+    itself. Starting and stopping only ever try-lock against the audio thread,
+    which skips the block rather than waiting if it loses the race.
+*/
+class CaptureRecorder  : private juce::Timer,
+                         private juce::AsyncUpdater
+{
+public:
+    enum class Format
+    {
+        wav = 0,
+        flac
+    };
+
+    enum class Mode
+    {
+        continuous = 0,
+        triggered      // pre-trigger ring, then post-trigger samples, then done
+    };
+
+    enum class State
+    {
+        idle = 0,
+        waitingForTrigger,
+        recording,
+        finished       // the post-trigger samples are written; the file closes shortly
+    };
+
+    struct Settings
+    {
+        Format format = Format::wav;
+        Mode mode = Mode::continuous;
+        int bitsPerSample = 24;
+        double preTriggerSeconds = 0.1;
+        double postTriggerSeconds = 2.0;
+    };
+
+    static constexpr double maxPreTriggerSeconds = 1.0;
+    static constexpr double bufferSeconds = 4.0;  // how far the disk may fall behind before blocks are dropped
+
+    CaptureRecorder();
+    ~CaptureRecorder() override;
+
+    //==============================================================================
+    /** Message thread: opens the file, replacing any existing one, and starts
+        recording numChannels channels. Stops any recording already running.
+    */
+    juce::Result start(const juce::File& file, const Settings& settings, double sampleRate, int numChannels);
+
+    /** Finishes the file, blocking until everything buffered is written.
+        Called from the message thread, or from prepareToPlay().
+    */
+    void stop();
+
+    State getState() const { return (State) state.load(std::memory_order_relaxed); }
+    bool isRecording() const { return getState() != State::idle; }
+    juce::File getFile() const { return file; }
+
+    /** Called on the message thread once a recording has closed its file,
+        whether it finished by itself or stop() was called.
+    */
+    std::function<void()> onFinished;
+
+    //==============================================================================
+    /** Audio thread: offers one block. triggerIndex is where the first accepted
+        trigger in it lies, as from TriggerEngine::getFirstTriggerInBlock().
+    */
+    void process(const juce::AudioBuffer<float>& buffer, int numSamples, int triggerIndex);
+
+    /** Samples per channel handed to the writer, and dropped because its FIFO was full. */
+    juce::uint64 getNumSamplesRecorded() const { return samplesRecorded.get(); }
+    juce::uint64 getNumSamplesDropped() const { return samplesDropped.get(); }
+
+private:
+    //==============================================================================
+    void timerCallback() override;
+    void handleAsyncUpdate() override;
+
+    void write(const juce::AudioBuffer<float>& source, int startSample, int numSamples);
+    void writePreTrigger(int numSamples);
+    void pushPreTrigger(const juce::AudioBuffer<float>& source, int startSample, int numSamples);
+
+    juce::TimeSliceThread writerThread { "Capture recorder" };
+    std::unique_ptr<juce::AudioFormatWriter::ThreadedWriter> writer;
+    juce::SpinLock writerLock;   // the audio thread only ever try-locks it
+    juce::File file;
+
+    // Audio thread, while a writer is set
+    Settings settings;
+    int numChannels = 0;
+    juce::HeapBlock<const float*> channelPointers;
+    juce::AudioBuffer<float> preTrigger;
+    int preTriggerWrite = 0, preTriggerFilled = 0;
+    int preTriggerSamples = 0;
+    juce::int64 postTriggerRemaining = 0;
+
+    std::atomic<int> state { (int) State::idle };
+    PerformanceCounter samplesRecorded, samplesDropped;   // written by the audio thread
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(CaptureRecorder)
+};
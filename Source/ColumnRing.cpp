@@ -0,0 +1,52 @@
+/*
+  ==============================================================================
+
+    This file contains the column ring, the scrolling image behind the
+    spectrogram and the roll display.
+
+  ==============================================================================
+*/
+
+#include "ColumnRing.h"
+
+//==============================================================================
+bool ColumnRing::setSize(int newWidth, int newHeight)
+{
+    newWidth = juce::jmax(1, newWidth);
+    newHeight = juce::jmax(1, newHeight);
+
+    if (image.isValid() && newWidth == width && newHeight == height)
+        return false;
+
+    width = newWidth;
+    height = newHeight;
+    writeColumn = 0;
+
+    // A software image, so BitmapData points straight at its pixels
+    image = juce::Image(juce::Image::ARGB, width, height, false, juce::SoftwareImageType());
+    return true;
+}
+
+void ColumnRing::clear(juce::Colour colour)
+{
+    if (image.isValid())
+        image.clear(image.getBounds(), colour);
+
+    writeColumn = 0;
+}
+
+void ColumnRing::draw(juce::Graphics& g, int logicalWidth, int logicalHeight) const
+{
+    if (!image.isValid() || logicalWidth <= 0 || logicalHeight <= 0)
+        return;
+
+    // Drawn in the image's own pixels, so each half is a straight blit
+    juce::Graphics::ScopedSaveState state(g);
+    g.addTransform(juce::AffineTransform::scale(logicalWidth / (float) width, logicalHeight / (float) height));
+
+    const auto olderWidth = width - writeColumn;
+    g.drawImage(image, 0, 0, olderWidth, height, writeColumn, 0, olderWidth, height);
+
+    if (writeColumn > 0)
+        g.drawImage(image, olderWidth, 0, writeColumn, height, 0, 0, writeColumn, height);
+}
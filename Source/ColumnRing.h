@@ -0,0 +1,57 @@
+/*
+  ==============================================================================
+
+    This file contains the column ring, the scrolling image behind the
+    spectrogram and the roll display.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+    An image used as a ring of pixel columns, for displays that scroll left
+    one column at a time with the newest on the right.
+
+    Each new column is written at the write position, which then moves on, so
+    nothing already drawn is touched again. draw() puts the ring together in
+    order as two blits, the older part from the write position to the right
+    edge, then the newer part from the left edge up to it. Scrolling therefore
+    costs one column of pixels however wide the display is.
+*/
+class ColumnRing
+{
+public:
+    ColumnRing() = default;
+
+    /** Sets the size in physical pixels. Returns true if it changed, in which
+        case the contents are undefined until the next clear().
+    */
+    bool setSize(int width, int height);
+
+    int getWidth() const { return width; }
+    int getHeight() const { return height; }
+    bool isValid() const { return image.isValid(); }
+
+    /** Fills every column and starts again from the left edge. */
+    void clear(juce::Colour colour);
+
+    /** The image to write the newest column into, at getWriteColumn(). */
+    juce::Image& getImage() { return image; }
+    int getWriteColumn() const { return writeColumn; }
+
+    /** Makes the column just written the newest. */
+    void advance() { writeColumn = (writeColumn + 1) % width; }
+
+    /** Draws the columns, oldest first, filling the given logical area. */
+    void draw(juce::Graphics& g, int logicalWidth, int logicalHeight) const;
+
+private:
+    juce::Image image;
+    int width = 0, height = 0, writeColumn = 0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ColumnRing)
+};
@@ -0,0 +1,133 @@
+/*
+  ==============================================================================
+
+    This file contains the goniometer, which plots one channel against another
+    as a density of sample pairs.
+
+  ==============================================================================
+*/
+
+#include "Goniometer.h"
+
+//==============================================================================
+Goniometer::Goniometer()
+{
+    xs.malloc((size_t) blockSize);
+    ys.malloc((size_t) blockSize);
+    lut.malloc((size_t) lutSize);
+    setColour(juce::Colours::lime);
+}
+
+void Goniometer::setSize(int newSize)
+{
+    newSize = juce::jmax(1, newSize);
+
+    if (image.isValid() && newSize == size)
+        return;
+
+    size = newSize;
+    density.calloc((size_t) size * (size_t) size);
+    image = juce::Image(juce::Image::ARGB, size, size, true, juce::SoftwareImageType());
+    clear();
+}
+
+void Goniometer::clear()
+{
+    juce::FloatVectorOperations::clear(density.get(), size * size);
+    totalWeight = 0.0f;
+}
+
+void Goniometer::setColour(juce::Colour colour)
+{
+    if (colour == lutColour)
+        return;
+
+    lutColour = colour;
+
+    // The table is indexed linearly in density, but graded logarithmically,
+    // so sparse pixels still show while the densest ones run towards white
+    for (int i = 0; i < lutSize; ++i)
+    {
+        auto relative = i * maxRelativeDensity / (lutSize - 1);
+        auto brightness = std::log1p(relative) / std::log1p(maxRelativeDensity);
+        auto shade = brightness < 0.8f ? colour.withAlpha(brightness / 0.8f)
+                                       : colour.interpolatedWith(juce::Colours::white, (brightness - 0.8f) / 0.2f);
+        lut[i] = shade.getPixelARGB();
+    }
+}
+
+//==============================================================================
+void Goniometer::decay(double elapsedSeconds)
+{
+    if (elapsedSeconds <= 0.0 || std::isinf(persistenceSeconds))
+        return;
+
+    auto factor = (float) std::exp(-elapsedSeconds / juce::jmax(1.0e-3, persistenceSeconds));
+
+    juce::FloatVectorOperations::multiply(density.get(), factor, size * size);
+    totalWeight *= factor;
+}
+
+void Goniometer::addSamples(const float* x, const float* y, int numSamples, Mode mode, float gain)
+{
+    const auto centre = size * 0.5f;
+    const auto radius = centre * 0.8f * gain;
+
+    for (int start = 0; start < numSamples; start += blockSize)
+    {
+        const auto num = juce::jmin(blockSize, numSamples - start);
+
+        // To pixel coordinates, y growing downwards
+        if (mode == Mode::midSide)
+        {
+            const auto rotated = radius * juce::MathConstants<float>::sqrt2 * 0.5f;
+            juce::FloatVectorOperations::subtract(xs.get(), y + start, x + start, num);
+            juce::FloatVectorOperations::add(ys.get(), x + start, y + start, num);
+            juce::FloatVectorOperations::multiply(xs.get(), rotated, num);
+            juce::FloatVectorOperations::multiply(ys.get(), -rotated, num);
+        }
+        else
+        {
+            juce::FloatVectorOperations::multiply(xs.get(), x + start, radius, num);
+            juce::FloatVectorOperations::multiply(ys.get(), y + start, -radius, num);
+        }
+
+        juce::FloatVectorOperations::add(xs.get(), centre, num);
+        juce::FloatVectorOperations::add(ys.get(), centre, num);
+
+        for (int i = 0; i < num; ++i)
+        {
+            // Negative coordinates must not truncate towards the centre
+            if (xs[i] >= 0.0f && ys[i] >= 0.0f)
+            {
+                const auto column = (int) xs[i];
+                const auto row = (int) ys[i];
+
+                if (column < size && row < size)
+                    density[(size_t) row * (size_t) size + (size_t) column] += 1.0f;
+            }
+        }
+    }
+
+    totalWeight += (float) numSamples;
+}
+
+void Goniometer::render()
+{
+    if (!image.isValid())
+        return;
+
+    juce::Image::BitmapData data(image, juce::Image::BitmapData::writeOnly);
+
+    // Relative to the density the same samples would have spread evenly
+    const auto scale = totalWeight > 0.0f ? (float) (size * size) / totalWeight * (lutSize - 1) / maxRelativeDensity : 0.0f;
+
+    for (int y = 0; y < size; ++y)
+    {
+        const auto* row = density + (size_t) y * (size_t) size;
+        auto* pixel = reinterpret_cast<juce::PixelARGB*>(data.getLinePointer(y));
+
+        for (int x = 0; x < size; ++x)
+            pixel[x].set(lut[juce::jmin(lutSize - 1, (int) (row[x] * scale))]);
+    }
+}
@@ -0,0 +1,78 @@
+/*
+  ==============================================================================
+
+    This file contains the goniometer, which plots one channel against another
+    as a density of sample pairs.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+    X-Y display of a pair of channels as a 2D histogram.
+
+    Every sample pair is binned into a float density buffer rather than joined
+    to the previous one with a line, so the picture stays smooth at the full
+    sample rate at the cost of one increment per sample. The coordinate
+    transform is done a block at a time with FloatVectorOperations; only the
+    final scatter into the histogram is scalar. The density decays
+    exponentially like the phosphor display, and render() maps it through a
+    colour lookup table, graded logarithmically, relative to the decayed
+    number of samples.
+*/
+class Goniometer
+{
+public:
+    enum class Mode
+    {
+        xy = 0,   // first channel along x, second up y
+        midSide   // rotated 45 degrees: mono is vertical, out-of-phase horizontal
+    };
+
+    Goniometer();
+
+    /** Sets the side of the square picture in pixels, clearing if it changed. */
+    void setSize(int size);
+    int getSize() const { return size; }
+
+    /** Forgets everything accumulated. */
+    void clear();
+
+    /** How long the picture takes to fade to 1/e. */
+    void setPersistence(double seconds) { persistenceSeconds = seconds; }
+
+    /** Sets the colour the densest pixels are drawn in. Cheap if it has not changed. */
+    void setColour(juce::Colour colour);
+
+    //==============================================================================
+    /** Fades everything by the given amount of display time. */
+    void decay(double elapsedSeconds);
+
+    /** Bins numSamples pairs. A gain of 1 puts full scale at 80% of the radius. */
+    void addSamples(const float* x, const float* y, int numSamples, Mode mode, float gain);
+
+    /** Maps the density into the image. */
+    void render();
+
+    const juce::Image& getImage() const { return image; }
+
+private:
+    static constexpr int lutSize = 4096;
+    static constexpr int blockSize = 1024;
+    static constexpr float maxRelativeDensity = 256.0f; // full brightness, relative to an even spread
+
+    juce::Image image;
+    juce::HeapBlock<float> density;       // [row][column]
+    juce::HeapBlock<float> xs, ys;        // pixel coordinates of one block
+    juce::HeapBlock<juce::PixelARGB> lut;
+    juce::Colour lutColour;
+    float totalWeight = 0.0f;             // decayed number of samples binned
+    int size = 0;
+    double persistenceSeconds = 0.1;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(Goniometer)
+};
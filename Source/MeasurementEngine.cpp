@@ -0,0 +1,239 @@
+/*
+  ==============================================================================
+
+    This file contains the measurement engine, which turns the captured signal
+    into numbers: level, DC offset, crest factor and frequency.
+
+  ==============================================================================
+*/
+
+#include "MeasurementEngine.h"
+#include "VectorReductions.h"
+
+//==============================================================================
+void MeasurementEngine::prepare(double newSampleRate)
+{
+    sampleRate = newSampleRate;
+    windowLength = juce::jmax(1, juce::roundToInt(sampleRate * windowSeconds));
+
+    recent.calloc((size_t) analysisSize);
+    recentWrite = recentFilled = 0;
+
+    results.reset();
+    currentChannel = -1;
+    crossingLevel = hysteresis = 0.0f;
+    hasCrossingLevel = false;
+    previousSample = 0.0f;
+    crossingArmed = false;
+    position = 0;
+    startWindow();
+}
+
+void MeasurementEngine::startWindow()
+{
+    windowFilled = 0;
+    sum = sumOfSquares = 0.0;
+    peak = 0.0f;
+    numCrossings = 0;
+}
+
+//==============================================================================
+void MeasurementEngine::process(const float* samples, int numSamples, int channel)
+{
+    if (windowLength <= 0 || numSamples <= 0)
+        return;
+
+    if (channel != currentChannel)
+    {
+        currentChannel = channel;
+        recentFilled = 0;
+        crossingArmed = false;
+        startWindow();
+    }
+
+    // A block may finish one window and start the next
+    for (int done = 0; done < numSamples;)
+    {
+        auto length = juce::jmin(numSamples - done, windowLength - windowFilled);
+        accumulate(samples + done, length);
+        done += length;
+        windowFilled += length;
+
+        if (windowFilled == windowLength)
+        {
+            publish();
+            startWindow();
+        }
+    }
+}
+
+void MeasurementEngine::accumulate(const float* samples, int numSamples)
+{
+    sum += VectorReductions::sum(samples, numSamples);
+    sumOfSquares += VectorReductions::dotProduct(samples, samples, numSamples);
+
+    float lowest, highest;
+    juce::FloatVectorOperations::findMinAndMax(samples, numSamples, lowest, highest);
+    peak = juce::jmax(peak, -lowest, highest);
+
+    findCrossings(samples, numSamples);
+
+    // Keep the newest samples for refining the period
+    auto toCopy = juce::jmin(numSamples, analysisSize);
+    auto* source = samples + numSamples - toCopy;
+    auto firstRun = juce::jmin(toCopy, analysisSize - recentWrite);
+
+    juce::FloatVectorOperations::copy(recent + recentWrite, source, firstRun);
+    juce::FloatVectorOperations::copy(recent.get(), source + firstRun, toCopy - firstRun);
+    recentWrite = (recentWrite + toCopy) % analysisSize;
+    recentFilled = juce::jmin(analysisSize, recentFilled + toCopy);
+    position += numSamples;
+}
+
+void MeasurementEngine::findCrossings(const float* samples, int numSamples)
+{
+    const auto armLevel = crossingLevel - hysteresis;
+    auto previous = previousSample;
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        const auto sample = samples[i];
+
+        if (sample < armLevel)
+        {
+            crossingArmed = true;
+        }
+        else if (crossingArmed && sample >= crossingLevel && previous < crossingLevel)
+        {
+            // Where the line between the two samples meets the level
+            const auto time = (double) (position + i - 1) + (crossingLevel - previous) / (double) (sample - previous);
+
+            if (numCrossings++ == 0)
+                firstCrossing = time;
+
+            lastCrossing = time;
+            crossingArmed = false;
+        }
+
+        previous = sample;
+    }
+
+    previousSample = previous;
+}
+
+void MeasurementEngine::publish()
+{
+    auto& measurements = producerWindow.measurements;
+    measurements = {};
+    measurements.channel = currentChannel;
+    measurements.dc = (float) (sum / windowLength);
+    measurements.rms = (float) std::sqrt(sumOfSquares / windowLength);
+    measurements.peak = peak;
+
+    producerWindow.crossingPeriod = numCrossings >= 2 && hasCrossingLevel
+                                  ? (lastCrossing - firstCrossing) / (numCrossings - 1) : 0.0;
+
+    // The samples go along oldest first, for the consumer to refine the period from
+    const auto numSamples = recentFilled;
+    const auto start = (recentWrite - numSamples + analysisSize) % analysisSize;
+    const auto firstRun = juce::jmin(numSamples, analysisSize - start);
+    juce::FloatVectorOperations::copy(producerWindow.recent, recent + start, firstRun);
+    juce::FloatVectorOperations::copy(producerWindow.recent + firstRun, recent.get(), numSamples - firstRun);
+    producerWindow.numRecent = numSamples;
+
+    // The next window's crossings are found around this one's mean, clear of
+    // noise a tenth of its AC level
+    crossingLevel = measurements.dc;
+    hasCrossingLevel = true;
+    hysteresis = juce::jmax(1.0e-5f, relativeHysteresis * std::sqrt(juce::jmax(0.0f, juce::square(measurements.rms) - juce::square(measurements.dc))));
+
+    results.push(producerWindow);
+}
+
+double MeasurementEngine::refinePeriod(Window& window) const
+{
+    const auto period = window.crossingPeriod;
+    const auto numSamples = window.numRecent;
+
+    // At least two periods are needed to compare one with the next
+    if (2 * (juce::roundToInt(period) + 1) > numSamples || period < 2.0)
+        return period;
+
+    // Without the DC
+    auto* scratch = window.recent;
+    juce::FloatVectorOperations::add(scratch, -window.measurements.dc, numSamples);
+
+    auto getCorrelation = [&](int lag)
+    {
+        const auto count = numSamples - lag;
+        const auto energy = VectorReductions::dotProduct(scratch, scratch, count)
+                          * VectorReductions::dotProduct(scratch + lag, scratch + lag, count);
+        return energy > 0.0f ? VectorReductions::dotProduct(scratch, scratch + lag, count) / std::sqrt(energy) : 0.0f;
+    };
+
+    // Strong harmonics can cross the mean several times a period, so the
+    // crossings' spacing may be a fraction of it. The period is the shortest
+    // multiple of the spacing at which the signal repeats nearly as well as
+    // at any multiple.
+    float correlations[maxPeriodMultiple + 1] = {};
+    auto numMultiples = 0;
+    auto best = 0.0f;
+
+    while (numMultiples < maxPeriodMultiple && 2 * (juce::roundToInt(period * (numMultiples + 1)) + 1) <= numSamples)
+    {
+        ++numMultiples;
+        correlations[numMultiples] = getCorrelation(juce::roundToInt(period * numMultiples));
+        best = juce::jmax(best, correlations[numMultiples]);
+    }
+
+    auto multiple = 1;
+
+    while (multiple < numMultiples && correlations[multiple] < repeatThreshold * best)
+        ++multiple;
+
+    // The crossings time the period far better than the correlation can
+    if (multiple == 1)
+        return period;
+
+    // Otherwise the uneven crossings only place the peak to within a few
+    // samples: find it, then a parabola either side puts it between samples
+    auto lag = juce::roundToInt(period * multiple);
+    auto at = correlations[multiple];
+
+    for (int candidate = lag - multiple; candidate <= lag + multiple; ++candidate)
+    {
+        auto correlation = getCorrelation(candidate);
+
+        if (correlation > at && 2 * (candidate + 1) <= numSamples)
+        {
+            at = correlation;
+            lag = candidate;
+        }
+    }
+
+    const auto before = getCorrelation(lag - 1);
+    const auto after = getCorrelation(lag + 1);
+    const auto curvature = before - 2.0f * at + after;
+    const auto offset = curvature < 0.0f ? 0.5 * (before - after) / curvature : 0.0;
+
+    return lag + juce::jlimit(-1.0, 1.0, offset);
+}
+
+bool MeasurementEngine::popLatest(Measurements& latest)
+{
+    bool found = false;
+
+    while (results.pop(consumerWindow))
+        found = true;
+
+    if (!found)
+        return false;
+
+    // Only the newest window is worth refining
+    latest = consumerWindow.measurements;
+
+    if (consumerWindow.crossingPeriod > 0.0)
+        latest.frequency = sampleRate / refinePeriod(consumerWindow);
+
+    return true;
+}
@@ -0,0 +1,120 @@
+/*
+  ==============================================================================
+
+    This file contains the measurement engine, which turns the captured signal
+    into numbers: level, DC offset, crest factor and frequency.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "SpscQueue.h"
+
+//==============================================================================
+/**
+    Measures one channel on the audio thread as it is captured.
+
+    Each block is folded into running sums in O(block): a sum and a sum of
+    squares, reduced four lanes at a time so the compiler can keep them in
+    vector registers, and the block's extremes from FloatVectorOperations.
+    Rising crossings of the signal's mean, with hysteresis, are timed to a
+    fraction of a sample as they go by. Every windowSeconds the sums become one
+    set of measurements, which is queued for the display without locking.
+
+    The frequency comes from the average spacing of the crossings in the
+    window, which times a clean period to a small fraction of a sample. Strong
+    harmonics can cross the mean more than once a period, so the spacing is
+    checked by autocorrelating the most recent samples at multiples of it, and
+    the period refined there if the signal only repeats at a longer lag. That
+    takes a few dozen dot products over analysisSize samples, too much to land
+    on whichever block finishes a window, so the audio thread only queues the
+    spacing with a copy of those samples, and popLatest() refines it on the
+    consumer's thread.
+*/
+class MeasurementEngine
+{
+public:
+    struct Measurements
+    {
+        int channel = 0;
+        float rms = 0.0f, peak = 0.0f, dc = 0.0f;  // linear, full scale is 1
+        double frequency = 0.0;                    // 0 when no period was found
+
+        /** Peak over RMS, 0 for silence. */
+        float getCrestFactor() const { return rms > 0.0f ? peak / rms : 0.0f; }
+    };
+
+    static constexpr double windowSeconds = 0.2;
+    static constexpr int analysisSize = 4096;   // samples autocorrelated to refine the period
+    static constexpr float relativeHysteresis = 0.1f;
+    static constexpr int maxPeriodMultiple = 4;
+    static constexpr float repeatThreshold = 0.9f;
+
+    MeasurementEngine() = default;
+
+    /** Allocates for the sample rate and starts afresh. Neither side may be
+        running: the processor calls it under its capture lock, which the
+        consumer holds around popLatest().
+    */
+    void prepare(double sampleRate);
+
+    //==============================================================================
+    /** Audio thread: measures a block of the given channel. Changing channel
+        starts a new window.
+    */
+    void process(const float* samples, int numSamples, int channel);
+
+    /** Consumer: the most recent measurements, if any arrived since the last
+        call. This is where the frequency is refined, so call it from a thread
+        that can afford the work.
+    */
+    bool popLatest(Measurements& latest);
+
+private:
+    //==============================================================================
+    /** One window as queued: the frequency still to be refined from the
+        crossings' spacing and the samples the window ended with.
+    */
+    struct Window
+    {
+        Measurements measurements;
+        double crossingPeriod = 0.0;   // 0 when no period was found
+        int numRecent = 0;
+        float recent[analysisSize];    // oldest first
+    };
+
+    void startWindow();
+    void accumulate(const float* samples, int numSamples);
+    void findCrossings(const float* samples, int numSamples);
+    void publish();
+    double refinePeriod(Window& window) const;
+
+    double sampleRate = 0.0;
+    int windowLength = 0, windowFilled = 0;
+    int currentChannel = -1;
+
+    // The current window
+    double sum = 0.0, sumOfSquares = 0.0;
+    float peak = 0.0f;
+    int numCrossings = 0;
+    double firstCrossing = 0.0, lastCrossing = 0.0;
+
+    // Crossings are found relative to the previous window's mean and RMS
+    float crossingLevel = 0.0f, hysteresis = 0.0f;
+    bool hasCrossingLevel = false;   // none until the first window is over
+    float previousSample = 0.0f;
+    bool crossingArmed = false;
+    juce::int64 position = 0;
+
+    // The latest analysisSize samples, as a ring
+    juce::HeapBlock<float> recent;
+    int recentWrite = 0, recentFilled = 0;
+
+    // Each side has its own window to copy into and out of the queue
+    Window producerWindow, consumerWindow;
+    SpscQueue<Window> results { 8 };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(MeasurementEngine)
+};
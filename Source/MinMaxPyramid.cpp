@@ -0,0 +1,139 @@
+/*
+  ==============================================================================
+
+    This file contains the min/max summaries that let the display draw any
+    stretch of the captured signal in time proportional to its width.
+
+  ==============================================================================
+*/
+
+#include "MinMaxPyramid.h"
+
+//==============================================================================
+void MinMaxPyramid::setSize(int numChannels, int length)
+{
+    jassert(juce::isPowerOfTwo(length));
+
+    levelOffsets.clearQuick();
+    levelOffsets.add(0);
+
+    int totalSize = 0;
+
+    for (numLevels = 1; getRunLength(numLevels) <= length; ++numLevels)
+    {
+        levelOffsets.add(totalSize);
+        totalSize += length / getRunLength(numLevels);
+    }
+
+    minima.setSize(juce::jmax(numChannels, 1), juce::jmax(totalSize, 1));
+    maxima.setSize(juce::jmax(numChannels, 1), juce::jmax(totalSize, 1));
+    clear();
+}
+
+void MinMaxPyramid::clear()
+{
+    minima.clear();
+    maxima.clear();
+}
+
+void MinMaxPyramid::update(const juce::AudioBuffer<float>& samples, int start, int end, juce::uint64 channelMask)
+{
+    if (start >= end)
+        return;
+
+    const int numChannels = juce::jmin(samples.getNumChannels(), minima.getNumChannels());
+
+    for (int level = 1; level < numLevels; ++level)
+    {
+        const int shift = level * fanOutBits;
+        const int firstRun = start >> shift;
+        const int lastRun = (end - 1) >> shift;
+
+        for (int channel = 0; channel < numChannels; ++channel)
+        {
+            if ((channelMask & ((juce::uint64) 1 << channel)) == 0)
+                continue;
+
+            auto* mins = minima.getWritePointer(channel, levelOffsets[level]);
+            auto* maxs = maxima.getWritePointer(channel, levelOffsets[level]);
+
+            if (level == 1)
+            {
+                const auto* raw = samples.getReadPointer(channel);
+
+                for (int run = firstRun; run <= lastRun; ++run)
+                    juce::FloatVectorOperations::findMinAndMax(raw + run * fanOut, fanOut, mins[run], maxs[run]);
+            }
+            else
+            {
+                const auto* finerMins = minima.getReadPointer(channel, levelOffsets[level - 1]);
+                const auto* finerMaxs = maxima.getReadPointer(channel, levelOffsets[level - 1]);
+
+                for (int run = firstRun; run <= lastRun; ++run)
+                {
+                    mins[run] = juce::FloatVectorOperations::findMinimum(finerMins + run * fanOut, fanOut);
+                    maxs[run] = juce::FloatVectorOperations::findMaximum(finerMaxs + run * fanOut, fanOut);
+                }
+            }
+        }
+    }
+}
+
+juce::Range<float> MinMaxPyramid::getMinMax(const juce::AudioBuffer<float>& samples, int channel, int start, int end) const
+{
+    if (start >= end)
+        return {};
+
+    auto lowest = std::numeric_limits<float>::max();
+    auto highest = std::numeric_limits<float>::lowest();
+    addMinMax(samples, &channel, 1, start, end, &lowest, &highest);
+
+    return { lowest, highest };
+}
+
+void MinMaxPyramid::addMinMax(const juce::AudioBuffer<float>& samples, const int* channels, int numChannels,
+                              int start, int end, float* lowest, float* highest) const
+{
+    while (start < end)
+    {
+        // Take the coarsest summary that starts here and fits inside the range
+        int level = 0;
+
+        while (level + 1 < numLevels)
+        {
+            const int runLength = getRunLength(level + 1);
+
+            if ((start & (runLength - 1)) != 0 || start + runLength > end)
+                break;
+
+            ++level;
+        }
+
+        if (level == 0)
+        {
+            const int runEnd = juce::jmin(end, (start | (fanOut - 1)) + 1);
+
+            for (int i = 0; i < numChannels; ++i)
+            {
+                float runMin, runMax;
+                juce::FloatVectorOperations::findMinAndMax(samples.getReadPointer(channels[i], start), runEnd - start, runMin, runMax);
+                lowest[i] = juce::jmin(lowest[i], runMin);
+                highest[i] = juce::jmax(highest[i], runMax);
+            }
+
+            start = runEnd;
+        }
+        else
+        {
+            const int index = levelOffsets[level] + (start >> (level * fanOutBits));
+
+            for (int i = 0; i < numChannels; ++i)
+            {
+                lowest[i] = juce::jmin(lowest[i], minima.getSample(channels[i], index));
+                highest[i] = juce::jmax(highest[i], maxima.getSample(channels[i], index));
+            }
+
+            start += getRunLength(level);
+        }
+    }
+}
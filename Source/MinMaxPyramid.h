@@ -0,0 +1,68 @@
+/*
+  ==============================================================================
+
+    This file contains the min/max summaries that let the display draw any
+    stretch of the captured signal in time proportional to its width.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+    A multi-level min/max summary of a block of samples whose length is a power
+    of two. Level n holds the minimum and maximum of each aligned run of
+    fanOut^n samples; level 0 is the samples themselves, which the pyramid does
+    not own.
+
+    update() refreshes only the summaries that cover samples that changed, so
+    keeping the pyramid current costs the same as writing the samples.
+    getMinMax() returns the exact extremes of any range from at most
+    2 * fanOut values per level.
+*/
+class MinMaxPyramid
+{
+public:
+    static constexpr int fanOutBits = 3;
+    static constexpr int fanOut = 1 << fanOutBits;
+
+    MinMaxPyramid() = default;
+
+    /** Allocates summaries for numChannels blocks of length samples each.
+        length must be a power of two.
+    */
+    void setSize(int numChannels, int length);
+
+    /** Resets every summary to match a block of silence. */
+    void clear();
+
+    /** Recomputes the summaries covering [start, end) of samples, for the
+        channels in channelMask only.
+    */
+    void update(const juce::AudioBuffer<float>& samples, int start, int end,
+                juce::uint64 channelMask = ~(juce::uint64) 0);
+
+    /** Returns the smallest and largest sample in [start, end) of one channel. */
+    juce::Range<float> getMinMax(const juce::AudioBuffer<float>& samples, int channel, int start, int end) const;
+
+    /** Widens lowest[i] and highest[i] to take in the smallest and largest
+        sample in [start, end) of channels[i]. The range is split into summaries
+        once for all the channels rather than once per channel.
+    */
+    void addMinMax(const juce::AudioBuffer<float>& samples, const int* channels, int numChannels,
+                   int start, int end, float* lowest, float* highest) const;
+
+    int getNumLevels() const { return numLevels; }
+
+private:
+    static int getRunLength(int level) { return 1 << (level * fanOutBits); }
+
+    juce::AudioBuffer<float> minima, maxima; // every level of a channel, packed back to back
+    juce::Array<int> levelOffsets;           // where each level starts; index 0 is unused
+    int numLevels = 1;
+
+    JUCE_LEAK_DETECTOR(MinMaxPyramid)
+};
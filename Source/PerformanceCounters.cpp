@@ -0,0 +1,99 @@
+/*
+  ==============================================================================
+
+    This file contains the performance counters, which let the scope measure
+    itself cheaply enough to leave measuring all the time.
+
+  ==============================================================================
+*/
+
+#include "PerformanceCounters.h"
+
+//==============================================================================
+PerformanceHistogram::Snapshot PerformanceHistogram::getSnapshot() const
+{
+    // Not one atomic picture: a record() in progress may show in some fields
+    // and not others, which is at most one sample out
+    Snapshot snapshot;
+
+    for (int bucket = 0; bucket < numBuckets; ++bucket)
+        snapshot.counts[bucket] = counts[bucket].get();
+
+    snapshot.count = count.get();
+    snapshot.totalNanoseconds = totalNanoseconds.get();
+    return snapshot;
+}
+
+PerformanceHistogram::Snapshot PerformanceHistogram::Snapshot::since(const Snapshot& earlier) const
+{
+    Snapshot difference;
+
+    for (int bucket = 0; bucket < numBuckets; ++bucket)
+        difference.counts[bucket] = counts[bucket] - earlier.counts[bucket];
+
+    difference.count = count - earlier.count;
+    difference.totalNanoseconds = totalNanoseconds - earlier.totalNanoseconds;
+    return difference;
+}
+
+double PerformanceHistogram::Snapshot::getPercentileSeconds(double fraction) const
+{
+    if (count == 0)
+        return 0.0;
+
+    const auto target = juce::jmax((juce::uint64) 1, (juce::uint64) std::ceil(fraction * (double) count));
+    juce::uint64 seen = 0;
+
+    for (int bucket = 0; bucket < numBuckets; ++bucket)
+    {
+        seen += counts[bucket];
+
+        if (seen >= target)
+            return getBucketUpperEdge(bucket) * 1.0e-9;
+    }
+
+    return getBucketUpperEdge(numBuckets - 1) * 1.0e-9;
+}
+
+double PerformanceHistogram::getBucketUpperEdge(int bucket)
+{
+    if (bucket < bucketsPerOctave)
+        return bucket + 1.0;
+
+    const auto octave = bucket / bucketsPerOctave;
+    const auto step = bucket % bucketsPerOctave;
+    return std::ldexp(1.0 + (step + 1.0) / bucketsPerOctave, octave);
+}
+
+//==============================================================================
+PerformanceCounters::Snapshot PerformanceCounters::getSnapshot() const
+{
+    Snapshot snapshot;
+    snapshot.seconds = juce::Time::getMillisecondCounterHiRes() * 0.001;
+    snapshot.processBlockTime = processBlockTime.getSnapshot();
+    snapshot.renderTime = renderTime.getSnapshot();
+    snapshot.paintTime = paintTime.getSnapshot();
+    snapshot.samplesProcessed = samplesProcessed.get();
+    snapshot.framesRendered = framesRendered.get();
+    snapshot.framesPainted = framesPainted.get();
+    snapshot.framesSkipped = framesSkipped.get();
+    return snapshot;
+}
+
+PerformanceCounters::Snapshot PerformanceCounters::Snapshot::since(const Snapshot& earlier) const
+{
+    Snapshot difference;
+    difference.seconds = seconds - earlier.seconds;
+    difference.processBlockTime = processBlockTime.since(earlier.processBlockTime);
+    difference.renderTime = renderTime.since(earlier.renderTime);
+    difference.paintTime = paintTime.since(earlier.paintTime);
+    difference.samplesProcessed = samplesProcessed - earlier.samplesProcessed;
+    difference.framesRendered = framesRendered - earlier.framesRendered;
+    difference.framesPainted = framesPainted - earlier.framesPainted;
+    difference.framesSkipped = framesSkipped - earlier.framesSkipped;
+    difference.triggers = triggers - earlier.triggers;
+    difference.droppedBlocks = droppedBlocks - earlier.droppedBlocks;
+    difference.samplesRecorded = samplesRecorded - earlier.samplesRecorded;
+    difference.samplesNotRecorded = samplesNotRecorded - earlier.samplesNotRecorded;
+    return difference;
+}
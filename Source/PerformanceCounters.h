@@ -0,0 +1,152 @@
+/*
+  ==============================================================================
+
+    This file contains the performance counters, which let the scope measure
+    itself cheaply enough to leave measuring all the time.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+    A count that one thread adds to and any thread may read.
+
+    With a single writer the increment needs no read-modify-write instruction,
+    just a relaxed load and store, which costs the same as a plain variable.
+*/
+class PerformanceCounter
+{
+public:
+    /** Writer thread only. */
+    void add(juce::uint64 amount)
+    {
+        value.store(value.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+    }
+
+    juce::uint64 get() const { return value.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<juce::uint64> value { 0 };
+};
+
+//==============================================================================
+/**
+    A histogram of durations that one thread records into and any thread may read.
+
+    Buckets are spaced logarithmically, four to an octave, from a nanosecond
+    to a few seconds, so recording is a bit scan and two counter increments,
+    and any percentile is known to within 25%. Nothing is ever reset: readers
+    take snapshots and subtract an earlier one to look at a window of time.
+*/
+class PerformanceHistogram
+{
+public:
+    static constexpr int bucketsPerOctave = 4;
+    static constexpr int numOctaves = 32;
+    static constexpr int numBuckets = bucketsPerOctave * numOctaves;
+
+    /** Writer thread only. */
+    void record(juce::int64 ticks)
+    {
+        const auto nanoseconds = (juce::uint32) juce::jlimit((juce::int64) 0, (juce::int64) 0xffffffff,
+                                                             (juce::int64) ((double) ticks * getNanosecondsPerTick()));
+
+        counts[getBucket(nanoseconds)].add(1);
+        count.add(1);
+        totalNanoseconds.add(nanoseconds);
+    }
+
+    /** Writer thread only: records the time since startTicks, and returns now. */
+    juce::int64 recordSince(juce::int64 startTicks)
+    {
+        const auto now = juce::Time::getHighResolutionTicks();
+        record(now - startTicks);
+        return now;
+    }
+
+    //==============================================================================
+    /** The whole histogram at one moment, for any thread to read. */
+    struct Snapshot
+    {
+        juce::uint64 counts[numBuckets] = {};
+        juce::uint64 count = 0, totalNanoseconds = 0;
+
+        /** What was recorded after earlier was taken. */
+        Snapshot since(const Snapshot& earlier) const;
+
+        double getMeanSeconds() const { return count > 0 ? totalNanoseconds * 1.0e-9 / (double) count : 0.0; }
+
+        /** The upper edge of the bucket holding the given fraction of the
+            recorded durations, e.g. 0.5 for the median or 1 for the maximum.
+        */
+        double getPercentileSeconds(double fraction) const;
+    };
+
+    Snapshot getSnapshot() const;
+
+    //==============================================================================
+    static int getBucket(juce::uint32 nanoseconds)
+    {
+        if (nanoseconds < bucketsPerOctave)
+            return (int) nanoseconds;
+
+        // The octave, then the two bits below the top one
+        const auto octave = juce::findHighestSetBit(nanoseconds);
+        return octave * bucketsPerOctave + (int) ((nanoseconds >> (octave - 2)) & (bucketsPerOctave - 1));
+    }
+
+    static double getBucketUpperEdge(int bucket);
+
+private:
+    static double getNanosecondsPerTick()
+    {
+        static const double nanosecondsPerTick = 1.0e9 / (double) juce::Time::getHighResolutionTicksPerSecond();
+        return nanosecondsPerTick;
+    }
+
+    PerformanceCounter counts[numBuckets];
+    PerformanceCounter count, totalNanoseconds;
+};
+
+//==============================================================================
+/**
+    Everything the scope counts about itself, grouped by the thread that
+    writes it. The processor owns one, so the figures survive the editor being
+    closed and reopened, and any code holding the processor can query them.
+*/
+struct PerformanceCounters
+{
+    // Audio thread
+    PerformanceHistogram processBlockTime;
+    PerformanceCounter samplesProcessed;
+
+    // Render thread: preparing a frame, from draining the capture to the swap
+    PerformanceHistogram renderTime;
+    PerformanceCounter framesRendered;
+
+    // Message thread
+    PerformanceHistogram paintTime;
+    PerformanceCounter framesPainted;
+    PerformanceCounter framesSkipped;   // requested while the previous one was still being prepared
+
+    //==============================================================================
+    /** Every figure at one moment, plus the ones other classes count. */
+    struct Snapshot
+    {
+        double seconds = 0.0;           // when it was taken, on the millisecond counter
+        PerformanceHistogram::Snapshot processBlockTime, renderTime, paintTime;
+        juce::uint64 samplesProcessed = 0, framesRendered = 0, framesPainted = 0, framesSkipped = 0;
+        juce::uint64 triggers = 0, droppedBlocks = 0;
+        juce::uint64 samplesRecorded = 0, samplesNotRecorded = 0;  // the disk could not keep up with the latter
+
+        /** What happened after earlier was taken. */
+        Snapshot since(const Snapshot& earlier) const;
+    };
+
+    /** Fills in everything but the figures from other classes. */
+    Snapshot getSnapshot() const;
+};
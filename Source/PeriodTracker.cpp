@@ -0,0 +1,168 @@
+/*
+  ==============================================================================
+
+    This file contains the period tracker, which holds a periodic signal still
+    on screen without relying on a trigger level.
+
+  ==============================================================================
+*/
+
+#include "PeriodTracker.h"
+
+//==============================================================================
+PeriodTracker::PeriodTracker()
+{
+    decimated.malloc((size_t) analysisSize);
+    fftData.malloc((size_t) fftSize * 2);
+}
+
+//==============================================================================
+bool PeriodTracker::process(const ScopeHistory& history, int channel, int span)
+{
+    const auto end = history.getEndPosition();
+    span = (int) juce::jmin((juce::int64) span, end - history.getValidStart(channel));
+
+    // The smallest power-of-two decimation that fits the span into the FFT
+    decimation = 1;
+
+    while (span / decimation > analysisSize)
+        decimation *= 2;
+
+    const auto numSamples = span / decimation;
+
+    if (numSamples < 16)
+        return false;
+
+    decimatedStart = end - (juce::int64) numSamples * decimation;
+    readDecimated(history, channel, decimatedStart, numSamples);
+
+    // Without the DC, which would otherwise dominate the correlation
+    float mean = 0.0f;
+
+    for (int i = 0; i < numSamples; ++i)
+        mean += decimated[i];
+
+    juce::FloatVectorOperations::add(decimated.get(), -mean / (float) numSamples, numSamples);
+
+    if (!findPeriod(numSamples))
+        return false;
+
+    findPhase(numSamples);
+    return true;
+}
+
+void PeriodTracker::readDecimated(const ScopeHistory& history, int channel, juce::int64 from, int numSamples)
+{
+    if (decimation == 1)
+    {
+        history.forEachRun(channel, from, from + numSamples, [&](const float* samples, int length, juce::int64 position)
+        {
+            juce::FloatVectorOperations::copy(decimated + (position - from), samples, length);
+        });
+
+        return;
+    }
+
+    // Box averages, which also keep what folds down from above the new Nyquist small
+    juce::FloatVectorOperations::clear(decimated.get(), numSamples);
+    const auto scale = 1.0f / (float) decimation;
+
+    history.forEachRun(channel, from, from + (juce::int64) numSamples * decimation, [&](const float* samples, int length, juce::int64 position)
+    {
+        for (int i = 0; i < length; ++i)
+            decimated[(position + i - from) / decimation] += samples[i] * scale;
+    });
+}
+
+bool PeriodTracker::findPeriod(int numSamples)
+{
+    // Wiener-Khinchin: the inverse transform of the power spectrum is the
+    // autocorrelation, and the zero padding keeps it from wrapping round
+    juce::FloatVectorOperations::clear(fftData.get(), fftSize * 2);
+    juce::FloatVectorOperations::copy(fftData.get(), decimated.get(), numSamples);
+    fft.performRealOnlyForwardTransform(fftData.get());
+
+    for (int bin = 0; bin < fftSize; ++bin)
+    {
+        auto& re = fftData[bin * 2];
+        auto& im = fftData[bin * 2 + 1];
+        re = re * re + im * im;
+        im = 0.0f;
+    }
+
+    fft.performRealOnlyInverseTransform(fftData.get());
+    const auto* correlation = fftData.get();
+
+    if (correlation[0] <= 0.0f)
+        return false;
+
+    // Past the central lobe, the highest peak sets the bar; the first peak
+    // near enough to it is the period, not one of its multiples
+    const auto maxLag = numSamples / 2;
+    auto lag = 1;
+
+    while (lag < maxLag && correlation[lag] > 0.0f)
+        ++lag;
+
+    const auto firstCandidate = lag;
+    auto highest = 0.0f;
+
+    for (lag = firstCandidate; lag < maxLag; ++lag)
+        highest = juce::jmax(highest, correlation[lag]);
+
+    if (highest < minClarity * correlation[0])
+        return false;
+
+    for (lag = juce::jmax(2, firstCandidate); lag < maxLag - 1; ++lag)
+        if (correlation[lag] >= peakThreshold * highest
+             && correlation[lag] >= correlation[lag - 1] && correlation[lag] >= correlation[lag + 1])
+            break;
+
+    if (lag >= maxLag - 1)
+        return false;
+
+    // A parabola through the peak and its neighbours puts it between samples
+    const auto before = correlation[lag - 1], at = correlation[lag], after = correlation[lag + 1];
+    const auto curvature = before - 2.0f * at + after;
+    const auto offset = curvature < 0.0f ? 0.5 * (before - after) / curvature : 0.0;
+
+    period = (lag + juce::jlimit(-0.5, 0.5, offset)) * decimation;
+    return true;
+}
+
+void PeriodTracker::findPhase(int numSamples)
+{
+    // Correlate the newest whole periods with a complex sinusoid at the
+    // fundamental, stepping its phase by rotation rather than calling sin and cos
+    const auto decimatedPeriod = period / decimation;
+    const auto numPeriods = juce::jmax(1, (int) (numSamples / decimatedPeriod));
+    const auto length = juce::jmin(numSamples, juce::roundToInt(numPeriods * decimatedPeriod));
+    const auto first = numSamples - length;
+
+    const auto step = -juce::MathConstants<double>::twoPi / decimatedPeriod;
+    const std::complex<double> rotation(std::cos(step), std::sin(step));
+    std::complex<double> phasor(1.0, 0.0), sum;
+
+    for (int i = first; i < numSamples; ++i)
+    {
+        sum += phasor * (double) decimated[i];
+        phasor *= rotation;
+    }
+
+    // The fundamental is cos(2 pi n / period + phase) from the first sample,
+    // which rises through zero where its argument is -pi/2
+    const auto phase = std::arg(sum);
+    const auto rising = std::fmod(-juce::MathConstants<double>::halfPi - phase, juce::MathConstants<double>::twoPi);
+
+    // Each decimated sample stands for the middle of the samples averaged into it
+    const auto decimatedTime = first + rising / juce::MathConstants<double>::twoPi * decimatedPeriod;
+    phaseZeroTime = (double) decimatedStart + decimatedTime * decimation + (decimation - 1) * 0.5;
+}
+
+double PeriodTracker::getLockedStart(double latestStart) const
+{
+    if (period <= 0.0)
+        return latestStart;
+
+    return phaseZeroTime + std::floor((latestStart - phaseZeroTime) / period) * period;
+}
@@ -0,0 +1,73 @@
+/*
+  ==============================================================================
+
+    This file contains the period tracker, which holds a periodic signal still
+    on screen without relying on a trigger level.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "ScopeHistory.h"
+
+//==============================================================================
+/**
+    Finds the period of the latest audio and where to start a frame so that
+    successive frames show the same part of the cycle.
+
+    A level trigger fires wherever the level is crossed, which a rich tone such
+    as a pad or a voice may do several times a period, so the display jumps
+    between them. This instead takes the period from the autocorrelation of the
+    recent signal, computed with one forward and one inverse FFT. The frame
+    then starts where the fundamental's phase, measured over whole periods,
+    passes through a rising zero, stepped back by whole periods to the latest
+    start there is data for.
+
+    The FFT has a fixed size. Longer spans are box-averaged down to fit it by a
+    power-of-two factor, so a long period costs reading the samples once but
+    no more FFT work than a short one.
+
+    Called by the render thread, which owns the history.
+*/
+class PeriodTracker
+{
+public:
+    static constexpr int fftOrder = 12;
+    static constexpr int fftSize = 1 << fftOrder;
+    static constexpr int analysisSize = fftSize / 2;  // zero-padded to fftSize, so the correlation does not wrap
+    static constexpr float minClarity = 0.5f;          // autocorrelation peak needed to call the signal periodic
+    static constexpr float peakThreshold = 0.9f;       // the first peak this close to the highest is the period
+
+    PeriodTracker();
+
+    /** Analyses the span of samples of one channel ending at the history's end.
+        Returns false if they have no clear period, or there are too few.
+    */
+    bool process(const ScopeHistory& history, int channel, int span);
+
+    /** The period found by the last successful process(), in samples. */
+    double getPeriod() const { return period; }
+
+    /** The latest frame start at or before latestStart that is in phase with
+        the cycle the last process() locked to.
+    */
+    double getLockedStart(double latestStart) const;
+
+private:
+    //==============================================================================
+    void readDecimated(const ScopeHistory& history, int channel, juce::int64 from, int numSamples);
+    bool findPeriod(int numSamples);
+    void findPhase(int numSamples);
+
+    juce::dsp::FFT fft { fftOrder };
+    juce::HeapBlock<float> decimated, fftData;
+    int decimation = 1;
+    juce::int64 decimatedStart = 0;
+
+    double period = 0.0;        // in samples
+    double phaseZeroTime = 0.0; // a timeline position where the fundamental rises through zero
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(PeriodTracker)
+};
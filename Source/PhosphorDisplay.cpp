@@ -0,0 +1,153 @@
+/*
+  ==============================================================================
+
+    This file contains the digital phosphor display, which shows how often
+    traces visit each pixel rather than only the latest one.
+
+  ==============================================================================
+*/
+
+#include "PhosphorDisplay.h"
+
+//==============================================================================
+void PhosphorDisplay::setSize(int newNumLayers, int newWidth, int newHeight, bool shouldBeStacked)
+{
+    newNumLayers = juce::jmax(1, newNumLayers);
+    newWidth = juce::jmax(1, newWidth);
+    newHeight = juce::jmax(1, newHeight);
+
+    if (image.isValid() && newNumLayers == numLayers && newWidth == width && newHeight == height
+         && shouldBeStacked == stacked)
+        return;
+
+    if (newNumLayers != numLayers)
+    {
+        luts.calloc((size_t) (newNumLayers * lutSize));
+        sweepTotals.calloc((size_t) newNumLayers);
+    }
+
+    numLayers = newNumLayers;
+    width = newWidth;
+    height = newHeight;
+    stacked = shouldBeStacked;
+
+    for (int layer = 0; layer < numLayers; ++layer)
+        setColour(layer, juce::Colours::white);
+
+    intensity.calloc(getNumValues());
+    image = juce::Image(juce::Image::ARGB, width, height, true, juce::SoftwareImageType());
+    clear();
+}
+
+void PhosphorDisplay::clear()
+{
+    juce::FloatVectorOperations::clear(intensity.get(), getNumValues());
+    juce::FloatVectorOperations::clear(sweepTotals.get(), numLayers);
+}
+
+void PhosphorDisplay::setColour(int layer, juce::Colour colour)
+{
+    if (!juce::isPositiveAndBelow(layer, numLayers))
+        return;
+
+    // Rarely visited pixels still show faintly; the most visited ones run
+    // through the layer colour towards white
+    for (int i = 0; i < lutSize; ++i)
+    {
+        auto fraction = i / (float) (lutSize - 1);
+        auto brightness = std::sqrt(fraction);
+        auto shade = brightness < 0.8f ? colour.withAlpha(brightness / 0.8f)
+                                       : colour.interpolatedWith(juce::Colours::white, (brightness - 0.8f) / 0.2f);
+        luts[layer * lutSize + i] = shade.getPixelARGB();
+    }
+}
+
+//==============================================================================
+void PhosphorDisplay::decay(double elapsedSeconds)
+{
+    if (elapsedSeconds <= 0.0 || std::isinf(persistenceSeconds))
+        return;
+
+    auto factor = (float) std::exp(-elapsedSeconds / juce::jmax(1.0e-3, persistenceSeconds));
+
+    juce::FloatVectorOperations::multiply(intensity.get(), factor, getNumValues());
+    juce::FloatVectorOperations::multiply(sweepTotals.get(), factor, numLayers);
+}
+
+void PhosphorDisplay::addSweep(int layer, const TraceColumns& trace, float weight, bool isNewSweep)
+{
+    if (!juce::isPositiveAndBelow(layer, numLayers) || weight <= 0.0f)
+        return;
+
+    const auto numColumns = juce::jmin(width, trace.getWidth());
+    const auto layerTop = (float) getLayerTop(layer);
+    const auto layerHeight = getLayerHeight(layer);
+
+    for (int x = 0; x < numColumns; ++x)
+    {
+        float top, bottom;
+
+        if (!trace.getSpan(x, top, bottom))
+            continue;
+
+        // Into the layer's own rows
+        top = juce::jmax(0.0f, top - layerTop);
+        bottom = juce::jmin((float) layerHeight, bottom - layerTop);
+
+        if (bottom <= top)
+            continue;
+
+        auto* column = getColumn(layer, x);
+        auto firstRow = (int) top;
+        auto endRow = juce::jmin(layerHeight, (int) std::ceil(bottom));
+
+        // Partly covered end rows get their share, the rows between the full weight
+        column[firstRow] += weight * (juce::jmin(bottom, (float) (firstRow + 1)) - top);
+
+        if (endRow - firstRow > 2)
+            juce::FloatVectorOperations::add(column + firstRow + 1, weight, endRow - firstRow - 2);
+
+        if (endRow - firstRow > 1)
+            column[endRow - 1] += weight * (bottom - (float) (endRow - 1));
+    }
+
+    if (isNewSweep)
+        sweepTotals[layer] += weight;
+}
+
+void PhosphorDisplay::render()
+{
+    if (!image.isValid())
+        return;
+
+    juce::Image::BitmapData data(image, juce::Image::BitmapData::writeOnly);
+
+    for (int layer = 0; layer < numLayers; ++layer)
+    {
+        const auto* lut = luts + layer * lutSize;
+        const auto scale = sweepTotals[layer] > 0.0f ? (lutSize - 1) / sweepTotals[layer] : 0.0f;
+        const auto layerTop = getLayerTop(layer);
+        const auto layerHeight = getLayerHeight(layer);
+
+        // Stacked layers and the first overlaid one overwrite last frame's
+        // picture, the other overlaid ones blend over it
+        const bool overwrites = stacked || layer == 0;
+
+        for (int x = 0; x < width; ++x)
+        {
+            const auto* column = getColumn(layer, x);
+            auto* pixel = data.getPixelPointer(x, layerTop);
+
+            for (int y = 0; y < layerHeight; ++y, pixel += data.lineStride)
+            {
+                auto index = juce::jmin(lutSize - 1, (int) (column[y] * scale + 0.5f));
+                auto* destination = reinterpret_cast<juce::PixelARGB*>(pixel);
+
+                if (overwrites)
+                    destination->set(lut[index]);
+                else if (index > 0)
+                    destination->blend(lut[index]);
+            }
+        }
+    }
+}
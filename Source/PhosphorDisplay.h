@@ -0,0 +1,93 @@
+/*
+  ==============================================================================
+
+    This file contains the digital phosphor display, which shows how often
+    traces visit each pixel rather than only the latest one.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "TraceRasterizer.h"
+
+//==============================================================================
+/**
+    Intensity-graded display. Each sweep adds its coverage to a float intensity
+    buffer per layer, the buffers decay exponentially with the chosen
+    persistence, and render() maps them through a colour lookup table.
+
+    Overlaid layers each cover the whole image and are blended together.
+    Stacked layers split the height between them, so their memory and render
+    cost stay those of a single layer however many lanes there are.
+
+    The buffers are stored column by column, so a sweep's span in a column is
+    one contiguous run and accumulation, like the decay, is a vectorized
+    FloatVectorOperations call. Intensities are shown relative to the decayed
+    number of sweeps, so a pixel every sweep passes through is at full
+    brightness however many sweeps arrive per frame.
+*/
+class PhosphorDisplay
+{
+public:
+    PhosphorDisplay() = default;
+
+    /** Sets the size and the layers, clearing if anything changed. */
+    void setSize(int numLayers, int width, int height, bool stacked);
+
+    int getNumLayers() const { return numLayers; }
+    int getWidth() const { return width; }
+    int getHeight() const { return height; }
+    bool isStacked() const { return stacked; }
+
+    /** First row of a layer. Stacked layers run down the image in order. */
+    int getLayerTop(int layer) const { return stacked ? layer * height / numLayers : 0; }
+    int getLayerHeight(int layer) const { return stacked ? getLayerTop(layer + 1) - getLayerTop(layer) : height; }
+
+    /** Forgets everything accumulated. */
+    void clear();
+
+    /** How long a trace takes to fade to 1/e. Infinity keeps it forever. */
+    void setPersistence(double seconds) { persistenceSeconds = seconds; }
+
+    /** Sets the colour a layer's most visited pixels are drawn in. */
+    void setColour(int layer, juce::Colour colour);
+
+    //==============================================================================
+    /** Fades everything by the given amount of display time. */
+    void decay(double elapsedSeconds);
+
+    /** Adds one sweep to a layer, clipped to its rows. The weight lets a sweep
+        stand in for others that were skipped to stay within the frame budget.
+        When several traces share a layer, pass isNewSweep for the first only,
+        so brightness stays relative to the number of sweeps.
+    */
+    void addSweep(int layer, const TraceColumns& trace, float weight, bool isNewSweep = true);
+
+    /** Maps every layer through its lookup table into the image. */
+    void render();
+
+    const juce::Image& getImage() const { return image; }
+
+private:
+    static constexpr int lutSize = 256;
+
+    size_t getNumValues() const { return (size_t) width * (size_t) height * (size_t) (stacked ? 1 : numLayers); }
+
+    float* getColumn(int layer, int column)
+    {
+        auto layerStart = (size_t) width * (size_t) (stacked ? getLayerTop(layer) : layer * height);
+        return intensity + layerStart + (size_t) column * (size_t) getLayerHeight(layer);
+    }
+
+    juce::Image image;
+    juce::HeapBlock<float> intensity;       // [layer][column][row]
+    juce::HeapBlock<float> sweepTotals;     // decayed sweep weight per layer
+    juce::HeapBlock<juce::PixelARGB> luts;  // [layer][lutSize]
+    int numLayers = 0, width = 0, height = 0;
+    bool stacked = false;
+    double persistenceSeconds = 0.5;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(PhosphorDisplay)
+};
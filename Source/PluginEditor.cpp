@@ -11,14 +11,30 @@
 
 //==============================================================================
 OscilloscopeComponent::OscilloscopeComponent(SCOPESCT002AudioProcessor& proc)
-    : processor(proc)
+    : processor(proc), renderer(proc),
+      vBlankAttachment(this, [this] { onVBlank(); })
 {
-    // Don't start timer immediately - wait until component is properly set up
+    // The trigger engine outlives the editor, so bring it in line with the
+    // controls, which always start from their defaults
+    auto& triggerEngine = processor.getTriggerEngine();
+    triggerEngine.setLevel(settings.triggerLevel);
+    triggerEngine.setHysteresis(0.0f);
+    triggerEngine.setSlope(TriggerDetector::Slope::rising);
+    triggerEngine.setMode(TriggerEngine::Mode::automatic);
+    triggerEngine.setHoldoff(0.0);
+    
+    // Unlike the other controls, the channel selection is saved with the plugin
+    setChannelMask(processor.getCaptureChannelMask());
+    
+    // Every pixel comes from the renderer's opaque frame
+    setOpaque(true);
+    
+    // Don't start the renderer immediately - wait until component is properly set up
 }
 
 OscilloscopeComponent::~OscilloscopeComponent()
 {
-    stopTimer();
+    renderer.stop();
 }
 
 void OscilloscopeComponent::paint(juce::Graphics& g)
@@ -26,166 +42,325 @@ void OscilloscopeComponent::paint(juce::Graphics& g)
     auto bounds = getLocalBounds();
     if (bounds.isEmpty())
         return;
-        
-    g.fillAll(juce::Colours::black);
     
-    drawGrid(g);
+    const auto startTicks = juce::Time::getHighResolutionTicks();
+    renderer.drawFrame(g, getWidth(), getHeight());
+    
+    if (showPerformance)
+        drawPerformanceOverlay(g);
     
-    if (channelMode == 0 || channelMode == 2) // Left or Stereo
-        drawWaveform(g, 0, juce::Colours::cyan);
+    auto& counters = processor.getPerformanceCounters();
+    counters.paintTime.recordSince(startTicks);
+    counters.framesPainted.add(1);
     
-    if (channelMode == 1 || channelMode == 2) // Right or Stereo
-        drawWaveform(g, 1, juce::Colours::yellow);
+    // The physical pixel scale is only known here; the next frame picks it up
+    auto scale = g.getInternalContext().getPhysicalPixelScaleFactor();
     
-    // Draw trigger level line
-    if (triggerEnabled)
+    if (scale != settings.scale)
     {
-        g.setColour(juce::Colours::red);
-        float y = getHeight() * 0.5f - (triggerLevel * amplitudeScale * getHeight() * 0.4f);
-        g.drawHorizontalLine(juce::roundToInt(y), 0.0f, (float)getWidth());
+        settings.scale = scale;
+        updateSettings();
     }
 }
 
-void OscilloscopeComponent::drawGrid(juce::Graphics& g)
+void OscilloscopeComponent::onVBlank()
 {
-    int width = getWidth();
-    int height = getHeight();
+    if (renderer.checkSingleShotFired() && onFrozenChanged != nullptr)
+        onFrozenChanged(true);
     
-    if (width <= 0 || height <= 0)
-        return;
-        
-    g.setColour(juce::Colours::darkgrey);
+    if (renderer.isNewFrameAvailable())
+        repaint();
+    
+    if (hasVisibleChange())
+        needsFrame = true;
+    
+    // Nothing is drawn for an occluded window; the frame is owed until it shows
+    auto* peer = getPeer();
+    bool isOccluded = !isShowing() || peer == nullptr || peer->isMinimised();
+    auto now = juce::Time::getMillisecondCounterHiRes() * 0.001;
     
-    // Vertical grid lines
-    for (int i = 1; i < 10; ++i)
+    if (showPerformance && now - lastPerformance.seconds >= performanceIntervalSeconds)
+        updatePerformanceOverlay();
+    
+    if (needsFrame && !isOccluded)
+    {
+        needsFrame = false;
+        renderer.requestFrame();
+        lastRequestTime = now;
+    }
+    else if (now - lastRequestTime >= idleIntervalSeconds)
     {
-        float x = width * i / 10.0f;
-        g.drawVerticalLine(juce::roundToInt(x), 0.0f, (float)height);
+        renderer.requestDrain();
+        lastRequestTime = now;
     }
+}
+
+bool OscilloscopeComponent::hasVisibleChange()
+{
+    auto captureEnd = processor.getCaptureEndPosition();
+    auto triggerGeneration = processor.getTriggerEngine().getGeneration();
+    bool hasNewData = captureEnd != lastCaptureEnd;
+    bool hasNewTrigger = triggerGeneration != lastTriggerGeneration;
     
-    // Horizontal grid lines
-    for (int i = 1; i < 8; ++i)
+    lastCaptureEnd = captureEnd;
+    lastTriggerGeneration = triggerGeneration;
+    
+    // A frozen picture only changes with the settings
+    if (renderer.isFrozen())
+        return false;
+    
+    if (hasNewTrigger)
+        return true;
+    
+    if (!hasNewData)
+        return false;
+    
+    // Once silence fills the screen, and any phosphor glow has faded, more
+    // silence draws exactly the same picture
+    auto fadeSeconds = settings.mode == ScopeRenderer::DisplayMode::spectrum
+                     ? juce::jmin(10.0, settings.spectrum.averagingSeconds * 5.0)
+                     : juce::jmin(10.0, settings.persistenceSeconds * 5.0);
+    auto visibleSamples = getSamplesToDisplay();
+    
+    // The goniometer shows no time at all, only its fade, which it always has
+    if (settings.mode == ScopeRenderer::DisplayMode::goniometer)
     {
-        float y = height * i / 8.0f;
-        g.drawHorizontalLine(juce::roundToInt(y), 0.0f, (float)width);
+        visibleSamples = 0.0;
+        fadeSeconds = juce::jmin(10.0, (settings.persistenceSeconds > 0.0 ? settings.persistenceSeconds : 0.1) * 5.0);
     }
     
-    // Center lines
-    g.setColour(juce::Colours::grey);
-    g.drawVerticalLine(width / 2, 0.0f, (float)height);
-    g.drawHorizontalLine(height / 2, 0.0f, (float)width);
+    if (settings.mode == ScopeRenderer::DisplayMode::spectrum)
+        visibleSamples = (double) (1 << settings.spectrum.order);
+    
+    // The spectrogram keeps scrolling until silence fills every column
+    if (settings.mode == ScopeRenderer::DisplayMode::spectrogram)
+        visibleSamples = (1 << settings.spectrum.order) * (1.0 + (1.0 - settings.spectrum.overlap) * settings.width * settings.scale);
+    auto settleSamples = visibleSamples + fadeSeconds * processor.getSampleRate();
+    
+    return (double) (captureEnd - processor.getLastSoundPosition()) <= settleSamples;
+}
+
+void OscilloscopeComponent::setPerformanceOverlayVisible(bool shouldBeVisible)
+{
+    showPerformance = shouldBeVisible;
+    
+    // The first figures shown cover everything since the plugin was loaded
+    lastPerformance = {};
+    performanceLines.clear();
+    
+    if (showPerformance)
+        updatePerformanceOverlay();
+    
+    repaint();
 }
 
-void OscilloscopeComponent::drawWaveform(juce::Graphics& g, int channel, juce::Colour colour)
+void OscilloscopeComponent::updatePerformanceOverlay()
 {
-    int width = getWidth();
-    int height = getHeight();
+    auto current = processor.getPerformanceSnapshot();
+    auto window = current.since(lastPerformance);
+    lastPerformance = current;
     
-    if (width <= 0 || height <= 0 || channel < 0 || channel >= 2)
+    if (window.seconds <= 0.0)
         return;
-        
-    const float* data;
-    int numSamples;
-    bool useProcessorData = !isFrozen;
     
-    if (useProcessorData)
+    auto formatTime = [](double seconds)
     {
-        data = processor.getCircularBufferData(channel);
-        numSamples = processor.getCircularBufferSize();
-    }
-    else
+        return seconds < 1.0e-3 ? juce::String(seconds * 1.0e6, 1) + " us" : juce::String(seconds * 1.0e3, 2) + " ms";
+    };
+    
+    auto formatPercentiles = [&](const PerformanceHistogram::Snapshot& histogram)
     {
-        if (frozenBuffer[channel].size() == 0) return;
-        data = frozenBuffer[channel].getRawDataPointer();
-        numSamples = frozenBuffer[channel].size();
-    }
+        return "p50 " + formatTime(histogram.getPercentileSeconds(0.5))
+             + "  p99 " + formatTime(histogram.getPercentileSeconds(0.99))
+             + "  max " + formatTime(histogram.getPercentileSeconds(1.0));
+    };
     
-    if (numSamples == 0 || data == nullptr) return;
+    // The share of real time spent in processBlock
+    auto sampleRate = processor.getSampleRate();
+    auto audioSeconds = sampleRate > 0.0 ? window.samplesProcessed / sampleRate : 0.0;
+    auto load = audioSeconds > 0.0 ? window.processBlockTime.totalNanoseconds * 1.0e-9 / audioSeconds : 0.0;
+    
+    performanceLines.clearQuick();
+    performanceLines.add("processBlock  " + formatPercentiles(window.processBlockTime)
+                         + "  load " + juce::String(load * 100.0, 2) + "%");
+    performanceLines.add("capture  " + juce::String(juce::roundToInt(window.samplesProcessed / window.seconds)) + " samples/s  "
+                         + juce::String((juce::int64) window.droppedBlocks) + " blocks dropped");
+    performanceLines.add("triggers  " + juce::String(window.triggers / window.seconds, 1) + "/s");
+    
+    if (processor.getRecorder().isRecording())
+        performanceLines.add("record  " + juce::String(juce::roundToInt(window.samplesRecorded / window.seconds)) + " samples/s  "
+                             + juce::String((juce::int64) window.samplesNotRecorded) + " samples dropped");
+    performanceLines.add("prepare  " + formatPercentiles(window.renderTime) + "  "
+                         + juce::String(window.framesRendered / window.seconds, 1) + " fps  "
+                         + juce::String((juce::int64) window.framesSkipped) + " skipped");
+    performanceLines.add("paint  " + formatPercentiles(window.paintTime) + "  "
+                         + juce::String(window.framesPainted / window.seconds, 1) + " fps");
     
-    g.setColour(colour);
+    repaint();
+}
+
+void OscilloscopeComponent::drawPerformanceOverlay(juce::Graphics& g) const
+{
+    if (performanceLines.isEmpty())
+        return;
     
-    waveformPath[channel].clear();
+    const int lineHeight = 15;
+    auto area = juce::Rectangle<int>(getWidth() - 430, 0, 430, performanceLines.size() * lineHeight + 8).reduced(4);
     
-    int samplesToDisplay = juce::jmin(numSamples, juce::roundToInt(width * timeScale));
-    int startSample = 0;
+    g.setColour(juce::Colours::black.withAlpha(0.7f));
+    g.fillRect(area);
     
-    if (triggerEnabled && !isFrozen)
-    {
-        startSample = findTriggerPoint(data, numSamples);
-    }
-    else if (useProcessorData)
-    {
-        startSample = processor.getCircularBufferPosition();
-    }
+    g.setFont(12.0f);
+    g.setColour(juce::Colours::white);
+    area.reduce(6, 0);
     
-    for (int i = 0; i < samplesToDisplay && i < width; ++i)
-    {
-        int sampleIndex = (startSample + i) % numSamples;
-        float sample = data[sampleIndex];
-        
-        float x = (float)i * width / samplesToDisplay;
-        float y = height * 0.5f - (sample * amplitudeScale * height * 0.4f);
-        
-        if (i == 0)
-            waveformPath[channel].startNewSubPath(x, y);
-        else
-            waveformPath[channel].lineTo(x, y);
-    }
+    for (auto& line : performanceLines)
+        g.drawText(line, area.removeFromTop(lineHeight), juce::Justification::centredLeft);
+}
+
+void OscilloscopeComponent::setTriggerLevel(float level)
+{
+    settings.triggerLevel = level;
+    processor.getTriggerEngine().setLevel(level);
+    updateSettings();
+}
+
+void OscilloscopeComponent::setTriggerMode(TriggerEngine::Mode mode)
+{
+    processor.getTriggerEngine().setMode(mode);
     
-    g.strokePath(waveformPath[channel], juce::PathStrokeType(1.0f));
+    if (mode == TriggerEngine::Mode::single)
+        armSingleTrigger();
 }
 
-int OscilloscopeComponent::findTriggerPoint(const float* data, int numSamples)
+void OscilloscopeComponent::armSingleTrigger()
 {
-    int currentPos = processor.getCircularBufferPosition();
-    int searchStart = (currentPos - numSamples / 4 + numSamples) % numSamples;
+    renderer.armSingleTrigger();
+    setView(1.0, 0.0);
+    needsFrame = true;
     
-    for (int i = 0; i < numSamples / 2; ++i)
-    {
-        int index = (searchStart + i) % numSamples;
-        int nextIndex = (index + 1) % numSamples;
-        
-        if (data[index] <= triggerLevel && data[nextIndex] > triggerLevel)
-        {
-            return index;
-        }
-    }
+    if (onFrozenChanged != nullptr)
+        onFrozenChanged(false);
+}
+
+void OscilloscopeComponent::setChannelMask(juce::uint64 mask)
+{
+    settings.channelMask = mask;
+    updateSettings();
+    
+    // Hidden channels are not captured at all
+    processor.setCaptureChannelMask(mask);
+    
+    // Trigger on the first channel being shown
+    int firstChannel = 0;
     
-    return currentPos;
+    while (firstChannel < SCOPESCT002AudioProcessor::maxCaptureChannels - 1
+           && (mask & CaptureFifo::getChannelBit(firstChannel)) == 0)
+        ++firstChannel;
+    
+    processor.getTriggerEngine().setSourceChannel(mask != 0 ? firstChannel : 0);
 }
 
-void OscilloscopeComponent::timerCallback()
+void OscilloscopeComponent::setPersistence(double seconds)
 {
-    if (!isFrozen && isShowing() && getWidth() > 0 && getHeight() > 0)
-    {
-        repaint();
-    }
+    settings.persistenceSeconds = juce::jmax(0.0, seconds);
+    updateSettings();
+}
+
+void OscilloscopeComponent::setTempoSync(double length, bool inBars)
+{
+    // The history is made deep enough for any synced window up front, so the
+    // host changing tempo never reallocates it
+    processor.setTempoSyncEnabled(length > 0.0);
+    settings.syncLength = juce::jmax(0.0, length);
+    settings.syncBars = inBars;
+    updateSettings();
 }
 
 void OscilloscopeComponent::setFrozen(bool frozen)
 {
-    if (frozen && !isFrozen)
+    renderer.setFrozen(frozen);
+    needsFrame = true;
+    
+    // A running display always shows the latest frame
+    if (!frozen)
+        setView(1.0, 0.0);
+}
+
+//==============================================================================
+bool OscilloscopeComponent::canZoom() const
+{
+    // The trace only stays put to be explored once frozen
+    return renderer.isFrozen() && settings.mode == ScopeRenderer::DisplayMode::scope
+        && settings.persistenceSeconds <= 0.0;
+}
+
+void OscilloscopeComponent::setView(double zoom, double panSamples)
+{
+    if (zoom == settings.zoom && panSamples == settings.panSamples)
+        return;
+    
+    settings.zoom = zoom;
+    settings.panSamples = panSamples;
+    updateSettings();
+}
+
+void OscilloscopeComponent::mouseWheelMove(const juce::MouseEvent& e, const juce::MouseWheelDetails& wheel)
+{
+    if (!canZoom() || getWidth() <= 0)
     {
-        // Capture current waveform data
-        for (int ch = 0; ch < 2; ++ch)
-        {
-            const float* data = processor.getCircularBufferData(ch);
-            int numSamples = processor.getCircularBufferSize();
-            frozenBuffer[ch].clearQuick();
-            frozenBuffer[ch].addArray(data, numSamples);
-        }
+        Component::mouseWheelMove(e, wheel);
+        return;
     }
-    isFrozen = frozen;
-    repaint();
+    
+    // Starting from what was actually drawn, keep the sample under the mouse where it is
+    auto zoom = renderer.getAppliedZoom();
+    auto newZoom = juce::jlimit(1.0 / maxZoom, maxZoom, zoom * std::pow(2.0, wheel.deltaY * 4.0));
+    auto visibleSamples = getSamplesToDisplay();
+    auto offset = e.position.x / (double) getWidth() - 0.5;
+    
+    setView(newZoom, renderer.getAppliedPan() + offset * (visibleSamples / zoom - visibleSamples / newZoom));
+}
+
+double OscilloscopeComponent::getSamplesToDisplay() const
+{
+    // The renderer knows the synced window's length at the host's tempo; until
+    // its first pass, the time scale is all there is to go on
+    if (auto samples = renderer.getSamplesToDisplay())
+        return (double) samples;
+
+    return settings.width * (double) settings.timeScale;
+}
+
+void OscilloscopeComponent::mouseDown(const juce::MouseEvent&)
+{
+    dragStartPan = renderer.getAppliedPan();
+}
+
+void OscilloscopeComponent::mouseDrag(const juce::MouseEvent& e)
+{
+    if (!canZoom() || getWidth() <= 0)
+        return;
+    
+    // The trace follows the mouse
+    auto visibleSamples = getSamplesToDisplay() / renderer.getAppliedZoom();
+    setView(renderer.getAppliedZoom(), dragStartPan - e.getDistanceFromDragStartX() * visibleSamples / getWidth());
+}
+
+void OscilloscopeComponent::mouseDoubleClick(const juce::MouseEvent&)
+{
+    setView(1.0, 0.0);
 }
 
 void OscilloscopeComponent::resized()
 {
-    // Start timer only after component is properly sized
-    if (getWidth() > 0 && getHeight() > 0 && !isTimerRunning())
-    {
-        startTimerHz(60); // 60 FPS refresh rate
-    }
+    settings.width = getWidth();
+    settings.height = getHeight();
+    updateSettings();
+    
+    // Start the renderer only after component is properly sized
+    if (getWidth() > 0 && getHeight() > 0)
+        renderer.start();
 }
 
 //==============================================================================
@@ -201,13 +376,31 @@ SCOPESCT002AudioProcessorEditor::SCOPESCT002AudioProcessorEditor (SCOPESCT002Aud
     timeScaleLabel.setText("Time Scale", juce::dontSendNotification);
     addAndMakeVisible(timeScaleLabel);
     
-    timeScaleSlider.setRange(0.1, 5.0, 0.1);
+    timeScaleSlider.setRange(0.1, 50000.0, 0.1);
+    timeScaleSlider.setSkewFactorFromMidPoint(20.0);
     timeScaleSlider.setValue(1.0);
     timeScaleSlider.setTextBoxStyle(juce::Slider::TextBoxRight, false, 60, 20);
     timeScaleSlider.onValueChange = [this] { 
         oscilloscope.setTimeScale((float)timeScaleSlider.getValue()); 
     };
     addAndMakeVisible(timeScaleSlider);
+
+    // Tempo sync: whole notes for the note values, bars for the rest
+    struct SyncLength { const char* name; double length; bool inBars; };
+    static const SyncLength syncLengths[] = { { "Free", 0.0, false }, { "1/16", 1.0 / 16.0, false }, { "1/8", 1.0 / 8.0, false },
+                                              { "1/4", 1.0 / 4.0, false }, { "1/2", 1.0 / 2.0, false }, { "1 bar", 1.0, true },
+                                              { "2 bars", 2.0, true }, { "4 bars", 4.0, true } };
+
+    for (int i = 0; i < juce::numElementsInArray(syncLengths); ++i)
+        syncSelector.addItem(syncLengths[i].name, i + 1);
+
+    syncSelector.setSelectedId(1);
+    syncSelector.onChange = [this] {
+        const auto& sync = syncLengths[syncSelector.getSelectedId() - 1];
+        oscilloscope.setTempoSync(sync.length, sync.inBars);
+        timeScaleSlider.setEnabled(sync.length <= 0.0);
+    };
+    addAndMakeVisible(syncSelector);
     
     // Amplitude scale controls
     amplitudeScaleLabel.setText("Amplitude Scale", juce::dontSendNotification);
@@ -233,18 +426,175 @@ SCOPESCT002AudioProcessorEditor::SCOPESCT002AudioProcessorEditor (SCOPESCT002Aud
     };
     addAndMakeVisible(triggerLevelSlider);
     
-    // Channel selector
-    channelLabel.setText("Channel", juce::dontSendNotification);
+    slopeSelector.addItem("Rising", 1);
+    slopeSelector.addItem("Falling", 2);
+    slopeSelector.addItem("Both", 3);
+    slopeSelector.setSelectedId(1);
+    slopeSelector.onChange = [this] { 
+        oscilloscope.setTriggerSlope((TriggerDetector::Slope) (slopeSelector.getSelectedId() - 1)); 
+    };
+    addAndMakeVisible(slopeSelector);
+    
+    hysteresisLabel.setText("Hysteresis", juce::dontSendNotification);
+    addAndMakeVisible(hysteresisLabel);
+    
+    hysteresisSlider.setRange(0.0, 0.5, 0.01);
+    hysteresisSlider.setValue(0.0);
+    hysteresisSlider.setTextBoxStyle(juce::Slider::TextBoxRight, false, 50, 20);
+    hysteresisSlider.onValueChange = [this] { 
+        oscilloscope.setTriggerHysteresis((float)hysteresisSlider.getValue()); 
+    };
+    addAndMakeVisible(hysteresisSlider);
+    
+    // Channel selection, from a menu since there may be dozens of channels
+    channelLabel.setText("Channels", juce::dontSendNotification);
     addAndMakeVisible(channelLabel);
     
-    channelSelector.addItem("Left", 1);
-    channelSelector.addItem("Right", 2);
-    channelSelector.addItem("Stereo", 3);
-    channelSelector.setSelectedId(3);
-    channelSelector.onChange = [this] { 
-        oscilloscope.setChannelMode(channelSelector.getSelectedId() - 1); 
+    channelsButton.onClick = [this] { showChannelMenu(); };
+    updateChannelsButton();
+    addAndMakeVisible(channelsButton);
+    
+    viewSelector.addItem("Overlay", 1);
+    viewSelector.addItem("Stacked", 2);
+    viewSelector.setSelectedId(1);
+    viewSelector.onChange = [this] { 
+        oscilloscope.setStacked(viewSelector.getSelectedId() == 2); 
+    };
+    addAndMakeVisible(viewSelector);
+    
+    // Capture memory selector
+    memoryLabel.setText("Memory", juce::dontSendNotification);
+    addAndMakeVisible(memoryLabel);
+    
+    const double memoryLengths[] = { 0.1, 1.0, 10.0, 30.0, 60.0, 120.0 };
+    
+    for (int i = 0; i < juce::numElementsInArray(memoryLengths); ++i)
+    {
+        auto seconds = memoryLengths[i];
+        memorySelector.addItem(seconds < 1.0 ? juce::String(juce::roundToInt(seconds * 1000.0)) + " ms"
+                                             : juce::String(seconds, 0) + " s", i + 1);
+        
+        if (seconds <= audioProcessor.getCaptureSeconds())
+            memorySelector.setSelectedId(i + 1, juce::dontSendNotification);
+    }
+    
+    memorySelector.onChange = [this, memoryLengths] { 
+        audioProcessor.setCaptureSeconds(memoryLengths[memorySelector.getSelectedId() - 1]); 
+    };
+    addAndMakeVisible(memorySelector);
+    
+    // Trigger mode and holdoff
+    triggerModeSelector.addItem("Auto", 1);
+    triggerModeSelector.addItem("Normal", 2);
+    triggerModeSelector.addItem("Single", 3);
+    triggerModeSelector.setSelectedId(1);
+    triggerModeSelector.onChange = [this] { 
+        auto mode = (TriggerEngine::Mode) (triggerModeSelector.getSelectedId() - 1);
+        armButton.setEnabled(mode == TriggerEngine::Mode::single);
+        oscilloscope.setTriggerMode(mode); 
+    };
+    addAndMakeVisible(triggerModeSelector);
+    
+    armButton.setEnabled(false);
+    armButton.onClick = [this] { oscilloscope.armSingleTrigger(); };
+    addAndMakeVisible(armButton);
+    
+    holdoffLabel.setText("Holdoff", juce::dontSendNotification);
+    addAndMakeVisible(holdoffLabel);
+    
+    holdoffSlider.setRange(0.0, 500.0, 1.0);
+    holdoffSlider.setValue(0.0);
+    holdoffSlider.setTextValueSuffix(" ms");
+    holdoffSlider.setTextBoxStyle(juce::Slider::TextBoxRight, false, 60, 20);
+    holdoffSlider.onValueChange = [this] { 
+        oscilloscope.setTriggerHoldoff(holdoffSlider.getValue() / 1000.0); 
+    };
+    addAndMakeVisible(holdoffSlider);
+    
+    // Locking to the period holds tones steady that cross any level several times a cycle
+    periodLockButton.setButtonText("Period lock");
+    periodLockButton.onClick = [this] {
+        oscilloscope.setPeriodLock(periodLockButton.getToggleState());
+    };
+    addAndMakeVisible(periodLockButton);
+
+    sincButton.setButtonText("Sinc");
+    sincButton.onClick = [this] {
+        oscilloscope.setSincInterpolation(sincButton.getToggleState());
+    };
+    addAndMakeVisible(sincButton);
+    
+    // Phosphor persistence
+    persistenceLabel.setText("Persist", juce::dontSendNotification);
+    addAndMakeVisible(persistenceLabel);
+    
+    persistenceSelector.addItem("Off", 1);
+    persistenceSelector.addItem("100 ms", 2);
+    persistenceSelector.addItem("500 ms", 3);
+    persistenceSelector.addItem("2 s", 4);
+    persistenceSelector.addItem("Infinite", 5);
+    persistenceSelector.setSelectedId(1);
+    persistenceSelector.onChange = [this] { 
+        const double persistenceTimes[] = { 0.0, 0.1, 0.5, 2.0, std::numeric_limits<double>::infinity() };
+        oscilloscope.setPersistence(persistenceTimes[persistenceSelector.getSelectedId() - 1]); 
+    };
+    addAndMakeVisible(persistenceSelector);
+    
+    // Display mode, and the spectrum analyser's settings
+    displayModeSelector.addItem("Scope", 1);
+    displayModeSelector.addItem("Spectrum", 2);
+    displayModeSelector.addItem("Spectrogram", 3);
+    displayModeSelector.addItem("X-Y", 4);
+    displayModeSelector.addItem("M/S", 5);
+    displayModeSelector.addItem("Roll", 6);
+    displayModeSelector.setSelectedId(1);
+    displayModeSelector.onChange = [this] { 
+        // X-Y and M/S are the same goniometer, rotated
+        auto id = displayModeSelector.getSelectedId();
+        oscilloscope.setMidSide(id == 5);
+        oscilloscope.setDisplayMode(id == 6 ? ScopeRenderer::DisplayMode::roll
+                                            : (ScopeRenderer::DisplayMode) (juce::jmin(id, 4) - 1)); 
+    };
+    addAndMakeVisible(displayModeSelector);
+    
+    for (int order = SpectrumAnalyser::minOrder; order <= SpectrumAnalyser::maxOrder; ++order)
+        fftSizeSelector.addItem(juce::String(1 << (order - 10)) + "k", order);
+    
+    fftSizeSelector.setSelectedId(12);
+    addAndMakeVisible(fftSizeSelector);
+    
+    fftWindowSelector.addItem("Hann", 1);
+    fftWindowSelector.addItem("Blackman-Harris", 2);
+    fftWindowSelector.addItem("Flat top", 3);
+    fftWindowSelector.addItem("Rectangular", 4);
+    fftWindowSelector.setSelectedId(1);
+    addAndMakeVisible(fftWindowSelector);
+    
+    fftOverlapSelector.addItem("0%", 1);
+    fftOverlapSelector.addItem("50%", 2);
+    fftOverlapSelector.addItem("75%", 3);
+    fftOverlapSelector.addItem("87.5%", 4);
+    fftOverlapSelector.setSelectedId(2);
+    addAndMakeVisible(fftOverlapSelector);
+    
+    averagingSelector.addItem("No avg", 1);
+    averagingSelector.addItem("Avg 100 ms", 2);
+    averagingSelector.addItem("Avg 500 ms", 3);
+    averagingSelector.addItem("Avg 2 s", 4);
+    averagingSelector.setSelectedId(1);
+    addAndMakeVisible(averagingSelector);
+    
+    peakHoldButton.setButtonText("Peak hold");
+    addAndMakeVisible(peakHoldButton);
+    
+    for (auto* selector : { &fftSizeSelector, &fftWindowSelector, &fftOverlapSelector, &averagingSelector })
+        selector->onChange = [this] { updateSpectrumSettings(); };
+    
+    peakHoldButton.onClick = [this] { updateSpectrumSettings(); };
+    
+    oscilloscope.onFrozenChanged = [this](bool frozen) {
+        freezeButton.setToggleState(frozen, juce::dontSendNotification);
     };
-    addAndMakeVisible(channelSelector);
     
     // Freeze button
     freezeButton.setButtonText("Freeze");
@@ -252,10 +602,175 @@ SCOPESCT002AudioProcessorEditor::SCOPESCT002AudioProcessorEditor (SCOPESCT002Aud
         oscilloscope.setFrozen(freezeButton.getToggleState()); 
     };
     addAndMakeVisible(freezeButton);
+    
+    // Reference traces
+    addReferenceButton.onClick = [this] { oscilloscope.addReference(); };
+    addAndMakeVisible(addReferenceButton);
+    
+    clearReferencesButton.onClick = [this] { oscilloscope.clearReferences(); };
+    addAndMakeVisible(clearReferencesButton);
+    
+    differenceButton.setButtonText("Difference");
+    differenceButton.onClick = [this] {
+        oscilloscope.setShowDifference(differenceButton.getToggleState());
+    };
+    addAndMakeVisible(differenceButton);
+    
+    // Performance overlay
+    performanceButton.setButtonText("Stats");
+    performanceButton.onClick = [this] {
+        oscilloscope.setPerformanceOverlayVisible(performanceButton.getToggleState());
+    };
+    addAndMakeVisible(performanceButton);
+    
+    // Recording to disk, which carries on with the editor closed
+    recordSelector.addItem("WAV", 1);
+    recordSelector.addItem("FLAC", 2);
+    recordSelector.addItem("Trigger WAV", 3);
+    recordSelector.addItem("Trigger FLAC", 4);
+    recordSelector.setSelectedId(1);
+    addAndMakeVisible(recordSelector);
+    
+    recordButton.setButtonText("Record");
+    recordButton.setToggleState(audioProcessor.getRecorder().isRecording(), juce::dontSendNotification);
+    recordButton.onClick = [this] { setRecording(recordButton.getToggleState()); };
+    addAndMakeVisible(recordButton);
+    
+    audioProcessor.getRecorder().onFinished = [this] {
+        recordButton.setToggleState(false, juce::dontSendNotification);
+    };
+    
+    // Measurement readout, refreshed a little faster than it is measured
+    measurementLabel.setFont(juce::Font(juce::FontOptions(juce::Font::getDefaultMonospacedFontName(), 13.0f, juce::Font::plain)));
+    addAndMakeVisible(measurementLabel);
+    startTimerHz(10);
 }
 
 SCOPESCT002AudioProcessorEditor::~SCOPESCT002AudioProcessorEditor()
 {
+    audioProcessor.getRecorder().onFinished = nullptr;
+}
+
+void SCOPESCT002AudioProcessorEditor::setRecording(bool shouldRecord)
+{
+    auto& recorder = audioProcessor.getRecorder();
+    
+    if (!shouldRecord)
+    {
+        recorder.stop();
+        return;
+    }
+    
+    auto id = recordSelector.getSelectedId();
+    CaptureRecorder::Settings recording;
+    recording.format = (id % 2) == 0 ? CaptureRecorder::Format::flac : CaptureRecorder::Format::wav;
+    recording.mode = id >= 3 ? CaptureRecorder::Mode::triggered : CaptureRecorder::Mode::continuous;
+    
+    auto file = juce::File::getSpecialLocation(juce::File::userDocumentsDirectory)
+                    .getChildFile("SCOPE Recordings")
+                    .getNonexistentChildFile("Capture " + juce::Time::getCurrentTime().formatted("%Y-%m-%d %H-%M-%S"),
+                                             recording.format == CaptureRecorder::Format::flac ? ".flac" : ".wav");
+    
+    auto result = recorder.start(file, recording, audioProcessor.getSampleRate(), audioProcessor.getNumCaptureChannels());
+    
+    if (result.failed())
+    {
+        recordButton.setToggleState(false, juce::dontSendNotification);
+        juce::AlertWindow::showMessageBoxAsync(juce::MessageBoxIconType::WarningIcon, "Recording", result.getErrorMessage());
+    }
+}
+
+void SCOPESCT002AudioProcessorEditor::timerCallback()
+{
+    MeasurementEngine::Measurements measurements;
+    
+    {
+        // prepareToPlay resets the queue under this lock, maybe on another thread
+        const juce::ScopedTryLock sl(audioProcessor.getCaptureLock());
+        
+        if (!sl.isLocked() || !audioProcessor.getMeasurementEngine().popLatest(measurements))
+            return;
+    }
+    
+    auto toDecibels = [](float gain)
+    {
+        return juce::String(juce::Decibels::gainToDecibels(gain, -120.0f), 1) + " dBFS";
+    };
+    
+    auto text = "Ch " + juce::String(measurements.channel + 1)
+              + "   RMS " + toDecibels(measurements.rms)
+              + "   Peak " + toDecibels(measurements.peak)
+              + "   DC " + juce::String(measurements.dc, 4)
+              + "   Crest " + juce::String(juce::Decibels::gainToDecibels(measurements.getCrestFactor(), 0.0f), 1) + " dB"
+              + "   Freq " + (measurements.frequency > 0.0 ? juce::String(measurements.frequency, 2) + " Hz" : juce::String("--"));
+    
+    measurementLabel.setText(text, juce::dontSendNotification);
+}
+
+void SCOPESCT002AudioProcessorEditor::updateSpectrumSettings()
+{
+    const float overlaps[] = { 0.0f, 0.5f, 0.75f, 0.875f };
+    const double averagingTimes[] = { 0.0, 0.1, 0.5, 2.0 };
+    
+    SpectrumAnalyser::Settings spectrum;
+    spectrum.order = fftSizeSelector.getSelectedId();
+    spectrum.window = (SpectrumAnalyser::Window) (fftWindowSelector.getSelectedId() - 1);
+    spectrum.overlap = overlaps[fftOverlapSelector.getSelectedId() - 1];
+    spectrum.averagingSeconds = averagingTimes[averagingSelector.getSelectedId() - 1];
+    spectrum.peakHold = peakHoldButton.getToggleState();
+    
+    oscilloscope.setSpectrumSettings(spectrum);
+}
+
+void SCOPESCT002AudioProcessorEditor::showChannelMenu()
+{
+    auto layout = audioProcessor.getChannelLayoutOfBus(true, 0);
+    auto numChannels = audioProcessor.getNumCaptureChannels();
+    auto mask = oscilloscope.getChannelMask();
+    
+    juce::PopupMenu menu;
+    menu.addItem(1, "All");
+    menu.addItem(2, "None");
+    menu.addSeparator();
+    
+    for (int channel = 0; channel < numChannels; ++channel)
+    {
+        // Named after the bus layout where it has names, e.g. "Ls" or "ACN4"
+        auto name = juce::String(channel + 1);
+        
+        if (channel < layout.size())
+            name << " " << juce::AudioChannelSet::getAbbreviatedChannelTypeName(layout.getTypeOfChannel(channel));
+        
+        menu.addItem(channel + 3, name, true, (mask & CaptureFifo::getChannelBit(channel)) != 0);
+    }
+    
+    menu.showMenuAsync(juce::PopupMenu::Options().withTargetComponent(&channelsButton),
+                       [this, mask](int result)
+    {
+        if (result == 0)
+            return;
+        
+        auto newMask = result == 1 ? ~(juce::uint64) 0
+                     : result == 2 ? (juce::uint64) 0
+                                   : mask ^ CaptureFifo::getChannelBit(result - 3);
+        
+        oscilloscope.setChannelMask(newMask);
+        updateChannelsButton();
+    });
+}
+
+void SCOPESCT002AudioProcessorEditor::updateChannelsButton()
+{
+    auto numChannels = audioProcessor.getNumCaptureChannels();
+    auto mask = oscilloscope.getChannelMask() & CaptureFifo::getAllChannelsMask(numChannels);
+    int numShown = 0;
+    
+    for (int channel = 0; channel < numChannels; ++channel)
+        if ((mask & CaptureFifo::getChannelBit(channel)) != 0)
+            ++numShown;
+    
+    channelsButton.setButtonText(numShown == numChannels ? juce::String("All")
+                                 : juce::String(numShown) + " of " + juce::String(numChannels));
 }
 
 //==============================================================================
@@ -269,7 +784,7 @@ void SCOPESCT002AudioProcessorEditor::resized()
     auto bounds = getLocalBounds();
     
     // Controls panel at the bottom
-    auto controlsArea = bounds.removeFromBottom(120);
+    auto controlsArea = bounds.removeFromBottom(200);
     controlsArea = controlsArea.reduced(10);
     
     // Split controls into rows
@@ -277,24 +792,80 @@ void SCOPESCT002AudioProcessorEditor::resized()
     auto row2 = controlsArea.removeFromTop(30);
     auto row3 = controlsArea.removeFromTop(30);
     auto row4 = controlsArea.removeFromTop(30);
+    auto row5 = controlsArea.removeFromTop(30);
+    auto row6 = controlsArea.removeFromTop(30);
     
     // Time scale row
     timeScaleLabel.setBounds(row1.removeFromLeft(100));
     timeScaleSlider.setBounds(row1.removeFromLeft(200));
+    row1.removeFromLeft(10); // spacing
+    syncSelector.setBounds(row1.removeFromLeft(80));
+    row1.removeFromLeft(10); // spacing
+    memoryLabel.setBounds(row1.removeFromLeft(60));
+    memorySelector.setBounds(row1.removeFromLeft(100));
+    row1.removeFromLeft(20); // spacing
+    viewSelector.setBounds(row1.removeFromLeft(90));
+    row1.removeFromLeft(20); // spacing
+    performanceButton.setBounds(row1.removeFromLeft(80));
     
     // Amplitude scale row  
     amplitudeScaleLabel.setBounds(row2.removeFromLeft(100));
     amplitudeScaleSlider.setBounds(row2.removeFromLeft(200));
+    row2.removeFromLeft(20); // spacing
+    persistenceLabel.setBounds(row2.removeFromLeft(60));
+    persistenceSelector.setBounds(row2.removeFromLeft(100));
+    row2.removeFromLeft(20); // spacing
+    addReferenceButton.setBounds(row2.removeFromLeft(70));
+    row2.removeFromLeft(5); // spacing
+    clearReferencesButton.setBounds(row2.removeFromLeft(80));
+    row2.removeFromLeft(10); // spacing
+    differenceButton.setBounds(row2.removeFromLeft(100));
     
     // Trigger level row
     triggerLevelLabel.setBounds(row3.removeFromLeft(100));
     triggerLevelSlider.setBounds(row3.removeFromLeft(200));
+    row3.removeFromLeft(20); // spacing
+    slopeSelector.setBounds(row3.removeFromLeft(90));
+    row3.removeFromLeft(10); // spacing
+    hysteresisLabel.setBounds(row3.removeFromLeft(80));
+    hysteresisSlider.setBounds(row3.removeFromLeft(170));
+    row3.removeFromLeft(10); // spacing
+    sincButton.setBounds(row3.removeFromLeft(70));
     
     // Channel selector and freeze button row
     channelLabel.setBounds(row4.removeFromLeft(60));
-    channelSelector.setBounds(row4.removeFromLeft(100));
+    channelsButton.setBounds(row4.removeFromLeft(100));
     row4.removeFromLeft(20); // spacing
     freezeButton.setBounds(row4.removeFromLeft(80));
+    row4.removeFromLeft(20); // spacing
+    triggerModeSelector.setBounds(row4.removeFromLeft(90));
+    row4.removeFromLeft(5); // spacing
+    armButton.setBounds(row4.removeFromLeft(50));
+    row4.removeFromLeft(20); // spacing
+    holdoffLabel.setBounds(row4.removeFromLeft(60));
+    holdoffSlider.setBounds(row4.removeFromLeft(170));
+    row4.removeFromLeft(10); // spacing
+    periodLockButton.setBounds(row4.removeFromLeft(95));
+    
+    // Display mode and spectrum row
+    displayModeSelector.setBounds(row5.removeFromLeft(100));
+    row5.removeFromLeft(20); // spacing
+    fftSizeSelector.setBounds(row5.removeFromLeft(70));
+    row5.removeFromLeft(10); // spacing
+    fftWindowSelector.setBounds(row5.removeFromLeft(130));
+    row5.removeFromLeft(10); // spacing
+    fftOverlapSelector.setBounds(row5.removeFromLeft(80));
+    row5.removeFromLeft(10); // spacing
+    averagingSelector.setBounds(row5.removeFromLeft(110));
+    row5.removeFromLeft(10); // spacing
+    peakHoldButton.setBounds(row5.removeFromLeft(90));
+    
+    // Recording row
+    recordSelector.setBounds(row6.removeFromLeft(120));
+    row6.removeFromLeft(10); // spacing
+    recordButton.setBounds(row6.removeFromLeft(80));
+    row6.removeFromLeft(20); // spacing
+    measurementLabel.setBounds(row6);
     
     // Oscilloscope takes the remaining space
     oscilloscope.setBounds(bounds.reduced(10));
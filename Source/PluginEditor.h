@@ -10,9 +10,10 @@
 
 #include <JuceHeader.h>
 #include "PluginProcessor.h"
+#include "ScopeRenderer.h"
 
 //==============================================================================
-class OscilloscopeComponent : public juce::Component, public juce::Timer
+class OscilloscopeComponent : public juce::Component
 {
 public:
     OscilloscopeComponent(SCOPESCT002AudioProcessor& processor);
@@ -20,36 +21,99 @@ public:
 
     void paint(juce::Graphics& g) override;
     void resized() override;
-    void timerCallback() override;
     
-    void setTimeScale(float scale) { timeScale = scale; }
-    void setAmplitudeScale(float scale) { amplitudeScale = scale; }
-    void setTriggerLevel(float level) { triggerLevel = level; }
-    void setChannelMode(int mode) { channelMode = mode; } // 0=left, 1=right, 2=stereo
+    // A frozen scope trace can be zoomed with the wheel, panned by dragging
+    // and put back with a double-click
+    void mouseWheelMove(const juce::MouseEvent& e, const juce::MouseWheelDetails& wheel) override;
+    void mouseDown(const juce::MouseEvent& e) override;
+    void mouseDrag(const juce::MouseEvent& e) override;
+    void mouseDoubleClick(const juce::MouseEvent& e) override;
+    
+    void setTimeScale(float scale) { settings.timeScale = scale; updateSettings(); }
+    void setAmplitudeScale(float scale) { settings.amplitudeScale = scale; updateSettings(); }
+    void setTriggerLevel(float level);
+    void setTriggerSlope(TriggerDetector::Slope slope) { processor.getTriggerEngine().setSlope(slope); }
+    void setTriggerHysteresis(float hysteresis) { processor.getTriggerEngine().setHysteresis(hysteresis); }
+    void setTriggerHoldoff(double seconds) { processor.getTriggerEngine().setHoldoff(seconds); }
+    void setTriggerMode(TriggerEngine::Mode mode);
+    void armSingleTrigger();
+    void setChannelMask(juce::uint64 mask); // see CaptureFifo::getChannelBit()
+    juce::uint64 getChannelMask() const { return settings.channelMask; }
+    void setStacked(bool stacked) { settings.stacked = stacked; updateSettings(); }
+    void setPersistence(double seconds); // 0 for the normal display, infinity to keep everything
     void setFrozen(bool frozen);
+    void setPeriodLock(bool periodLock) { settings.periodLock = periodLock; updateSettings(); } // instead of triggers
+    void setTempoSync(double length, bool inBars); // length in whole notes or bars, 0 for the time scale
+    void setSincInterpolation(bool sinc) { settings.sincInterpolation = sinc; updateSettings(); } // when zoomed in past the samples
+    void setDisplayMode(ScopeRenderer::DisplayMode mode) { settings.mode = mode; updateSettings(); }
+    void setMidSide(bool midSide) { settings.midSide = midSide; updateSettings(); } // for the goniometer
+    void addReference() { renderer.addReference(); needsFrame = true; }
+    void clearReferences() { renderer.clearReferences(); needsFrame = true; }
+    void setShowDifference(bool showDifference) { settings.showDifference = showDifference; updateSettings(); }
+    void setSpectrumSettings(const SpectrumAnalyser::Settings& spectrum) { settings.spectrum = spectrum; updateSettings(); }
+    
+    /** Shows the performance counters over the display, refreshed twice a second. */
+    void setPerformanceOverlayVisible(bool shouldBeVisible);
+    bool isPerformanceOverlayVisible() const { return showPerformance; }
+    
+    /** Renders a frame of whatever has been captured and waits for it, for
+        offline use where there is no vertical blank to drive the display.
+    */
+    bool renderFrameAndWait(int timeoutMilliseconds) { return renderer.renderFrameAndWait(timeoutMilliseconds); }
+    
+    /** Called when the display freezes or unfreezes itself, e.g. after a single shot. */
+    std::function<void(bool)> onFrozenChanged;
 
 private:
     SCOPESCT002AudioProcessor& processor;
     
-    float timeScale = 1.0f;
-    float amplitudeScale = 1.0f;
-    float triggerLevel = 0.0f;
-    int channelMode = 2; // stereo by default
-    bool isFrozen = false;
-    bool triggerEnabled = true;
+    // Frames are prepared on the renderer's thread; this component only
+    // forwards settings to it and blits what it produces
+    ScopeRenderer::Settings settings;
+    ScopeRenderer renderer;
+    
+    // Frames are requested on the display's vertical blank, but only when new
+    // audio could change the picture; otherwise the capture is just drained
+    juce::VBlankAttachment vBlankAttachment;
+    juce::int64 lastCaptureEnd = -1;
+    juce::uint64 lastTriggerGeneration = 0;
+    bool needsFrame = true;
+    double lastRequestTime = 0.0;
     
-    juce::Path waveformPath[2];
-    juce::Array<float> frozenBuffer[2];
+    // Often enough that the capture channel never fills while idle
+    static constexpr double idleIntervalSeconds = 0.1;
     
-    void drawWaveform(juce::Graphics& g, int channel, juce::Colour colour);
-    void drawGrid(juce::Graphics& g);
-    int findTriggerPoint(const float* data, int numSamples);
+    // The overlay shows the counters' change over the last interval
+    bool showPerformance = false;
+    juce::StringArray performanceLines;
+    PerformanceCounters::Snapshot lastPerformance;
+    static constexpr double performanceIntervalSeconds = 0.5;
+    
+    // Zoom and pan over a frozen capture
+    double dragStartPan = 0.0;
+    static constexpr double maxZoom = 1.0e6;
+    
+    bool canZoom() const;
+    double getSamplesToDisplay() const;
+    void setView(double zoom, double panSamples);
+    
+    void onVBlank();
+    bool hasVisibleChange();
+    void updatePerformanceOverlay();
+    void drawPerformanceOverlay(juce::Graphics& g) const;
+    
+    void updateSettings()
+    {
+        renderer.setSettings(settings);
+        needsFrame = true;
+    }
     
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(OscilloscopeComponent)
 };
 
 //==============================================================================
-class SCOPESCT002AudioProcessorEditor  : public juce::AudioProcessorEditor
+class SCOPESCT002AudioProcessorEditor  : public juce::AudioProcessorEditor,
+                                         private juce::Timer
 {
 public:
     SCOPESCT002AudioProcessorEditor (SCOPESCT002AudioProcessor&);
@@ -60,13 +124,22 @@ public:
     void resized() override;
 
 private:
+    void showChannelMenu();
+    void updateChannelsButton();
+    void updateSpectrumSettings();
+    void setRecording(bool shouldRecord);
+    void timerCallback() override;
+    
     SCOPESCT002AudioProcessor& audioProcessor;
     
     OscilloscopeComponent oscilloscope;
-    juce::Slider timeScaleSlider, amplitudeScaleSlider, triggerLevelSlider;
-    juce::ComboBox channelSelector;
-    juce::ToggleButton freezeButton;
-    juce::Label timeScaleLabel, amplitudeScaleLabel, triggerLevelLabel, channelLabel;
+    juce::Slider timeScaleSlider, amplitudeScaleSlider, triggerLevelSlider, hysteresisSlider, holdoffSlider;
+    juce::ComboBox memorySelector, syncSelector, slopeSelector, triggerModeSelector, persistenceSelector, viewSelector;
+    juce::ComboBox displayModeSelector, fftSizeSelector, fftWindowSelector, fftOverlapSelector, averagingSelector, recordSelector;
+    juce::ToggleButton freezeButton, peakHoldButton, performanceButton, differenceButton, recordButton, periodLockButton, sincButton;
+    juce::TextButton armButton { "Arm" }, channelsButton, addReferenceButton { "Add ref" }, clearReferencesButton { "Clear refs" };
+    juce::Label measurementLabel;
+    juce::Label timeScaleLabel, amplitudeScaleLabel, triggerLevelLabel, channelLabel, memoryLabel, hysteresisLabel, holdoffLabel, persistenceLabel;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SCOPESCT002AudioProcessorEditor)
 };
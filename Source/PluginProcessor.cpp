@@ -94,9 +94,102 @@ void SCOPESCT002AudioProcessor::changeProgramName (int index, const juce::String
 void SCOPESCT002AudioProcessor::prepareToPlay (double sampleRate, int samplesPerBlock)
 {
     currentSampleRate = sampleRate;
-    circularBuffer.setSize(2, bufferSize);
-    circularBuffer.clear();
-    circularBufferPosition = 0;
+    recorder.stop();
+
+    // Enough room for a quarter of a second of display stalls, and for
+    // hosts that split their callbacks into many small blocks
+    auto fifoSize = juce::jmax(samplesPerBlock * 8, juce::roundToInt(sampleRate * 0.25));
+
+    const juce::ScopedLock sl(captureLock);
+    numCaptureChannels.store(juce::jlimit(1, maxCaptureChannels, getTotalNumInputChannels()));
+    captureFifo.prepare(numCaptureChannels.load(), fifoSize, fifoSize / 16);
+    captureEndPosition.store(0);
+    lastSoundPosition.store(0);
+    triggerEngine.prepare(sampleRate);
+    measurementEngine.prepare(sampleRate);
+    resizeHistory();
+}
+
+void SCOPESCT002AudioProcessor::setCaptureSeconds(double seconds)
+{
+    seconds = juce::jlimit(minCaptureSeconds, maxCaptureSeconds, seconds);
+
+    const juce::ScopedLock sl(captureLock);
+
+    if (juce::approximatelyEqual(seconds, captureSeconds))
+        return;
+
+    captureSeconds = seconds;
+    resizeHistory();
+}
+
+void SCOPESCT002AudioProcessor::setTempoSyncEnabled(bool shouldBeEnabled)
+{
+    const juce::ScopedLock sl(captureLock);
+
+    if (shouldBeEnabled == tempoSyncEnabled)
+        return;
+
+    tempoSyncEnabled = shouldBeEnabled;
+    resizeHistory();
+}
+
+void SCOPESCT002AudioProcessor::resizeHistory()
+{
+    // Deep captures are allocated here, never on the audio thread, and capped so
+    // that a long setting at a high sample rate cannot take all the memory
+    auto seconds = captureSeconds;
+
+    // Synced frames start up to two windows back, and the newest tag may be a block old
+    if (tempoSyncEnabled)
+        seconds = juce::jmax(seconds, 2.0 * maxTempoSyncQuarters * 60.0 / minTempoSyncBpm + 1.0);
+
+    auto numSamples = (juce::int64) (seconds * currentSampleRate);
+    const auto numChannels = numCaptureChannels.load();
+    numSamples = juce::jmin(numSamples, maxCaptureBytes / (juce::int64) (sizeof(float) * (size_t) numChannels));
+
+    history.setSize(numChannels, numSamples);
+}
+
+CaptureFifo::MusicalPosition SCOPESCT002AudioProcessor::getMusicalPosition() const
+{
+    CaptureFifo::MusicalPosition musical;
+    auto* playHead = getPlayHead();
+
+    if (playHead == nullptr)
+        return musical;
+
+    const auto position = playHead->getPosition();
+
+    if (!position.hasValue())
+        return musical;
+
+    const auto ppq = position->getPpqPosition();
+    const auto bpm = position->getBpm();
+
+    if (!ppq.hasValue() || !bpm.hasValue() || *bpm <= 0.0)
+        return musical;
+
+    musical.ppq = *ppq;
+    musical.bpm = *bpm;
+    musical.isPlaying = position->getIsPlaying();
+
+    // Bars longer than the history is sized for count as the longest it holds
+    if (const auto timeSignature = position->getTimeSignature())
+    {
+        musical.denominator = juce::jmax(1, timeSignature->denominator);
+        const auto maxNumerator = (int) (maxTempoSyncQuartersPerBar * musical.denominator / 4.0);
+        musical.numerator = juce::jlimit(1, juce::jmax(1, maxNumerator), timeSignature->numerator);
+    }
+
+    // Hosts that do not say where the bar started get bars counted from zero
+    if (const auto barStart = position->getPpqPositionOfLastBarStart())
+        musical.barStartPpq = *barStart;
+    else
+        musical.barStartPpq = std::floor(musical.ppq / musical.getQuartersPerBar()) * musical.getQuartersPerBar();
+
+    musical.isValid = true;
+    return musical;
 }
 
 void SCOPESCT002AudioProcessor::releaseResources()
@@ -112,12 +205,10 @@ bool SCOPESCT002AudioProcessor::isBusesLayoutSupported (const BusesLayout& layou
     juce::ignoreUnused (layouts);
     return true;
   #else
-    // This is the place where you check if the layout is supported.
-    // In this template code we only support mono or stereo.
-    // Some plugin hosts, such as certain GarageBand versions, will only
-    // load plugins that support stereo bus layouts.
-    if (layouts.getMainOutputChannelSet() != juce::AudioChannelSet::mono()
-     && layouts.getMainOutputChannelSet() != juce::AudioChannelSet::stereo())
+    // Any layout the capture can hold: mono and stereo up to 7.1.4 and
+    // 7th order ambisonics
+    if (layouts.getMainOutputChannelSet().isDisabled()
+     || layouts.getMainOutputChannelSet().size() > maxCaptureChannels)
         return false;
 
     // This checks if the input layout matches the output layout
@@ -134,27 +225,79 @@ bool SCOPESCT002AudioProcessor::isBusesLayoutSupported (const BusesLayout& layou
 void SCOPESCT002AudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
 {
     juce::ScopedNoDenormals noDenormals;
+    const auto startTicks = juce::Time::getHighResolutionTicks();
     auto totalNumInputChannels  = getTotalNumInputChannels();
     auto totalNumOutputChannels = getTotalNumOutputChannels();
 
     for (auto i = totalNumInputChannels; i < totalNumOutputChannels; ++i)
         buffer.clear (i, 0, buffer.getNumSamples());
 
-    // Copy input data to circular buffer for oscilloscope display
-    for (int sample = 0; sample < buffer.getNumSamples(); ++sample)
+    // Publish the input to the oscilloscope display; never waits on the editor
+    auto numCapturedChannels = juce::jmin(totalNumInputChannels, captureFifo.getNumChannels());
+    auto channelMask = captureChannelMask.load(std::memory_order_relaxed);
+    auto capturePosition = captureFifo.getNextPosition();
+    const auto published = captureFifo.push(buffer, numCapturedChannels, buffer.getNumSamples(), channelMask, getMusicalPosition());
+
+    // Let the editor skip repaints when nothing new, or nothing audible, arrives
+    auto captureEnd = capturePosition + buffer.getNumSamples();
+
+    for (int channel = 0; channel < numCapturedChannels; ++channel)
     {
-        for (int channel = 0; channel < juce::jmin(totalNumInputChannels, 2); ++channel)
+        if ((channelMask & CaptureFifo::getChannelBit(channel)) != 0
+             && buffer.getMagnitude(channel, 0, buffer.getNumSamples()) > silenceThreshold)
         {
-            auto* channelData = buffer.getReadPointer(channel);
-            auto* circularData = circularBuffer.getWritePointer(channel);
-            circularData[circularBufferPosition] = channelData[sample];
+            lastSoundPosition.store(captureEnd, std::memory_order_relaxed);
+            break;
         }
-        circularBufferPosition = (circularBufferPosition + 1) % bufferSize;
     }
 
+    captureEndPosition.store(captureEnd, std::memory_order_relaxed);
+
+    // Triggers are found here, once per block, and queued for the display.
+    // A dropped block is only silence in the history, so it cannot trigger.
+    if (published)
+        triggerEngine.process(buffer, buffer.getNumSamples(), capturePosition);
+    else
+        triggerEngine.skip();
+
+    // The readout measures the channel the display triggers on
+    auto measuredChannel = triggerEngine.getSourceChannel();
+
+    if (juce::isPositiveAndBelow(measuredChannel, totalNumInputChannels))
+        measurementEngine.process(buffer.getReadPointer(measuredChannel), buffer.getNumSamples(), measuredChannel);
+
+    // Recording only copies into the writer's FIFO; its own thread does the disk
+    recorder.process(buffer, buffer.getNumSamples(), triggerEngine.getFirstTriggerInBlock());
+
+    performanceCounters.samplesProcessed.add((juce::uint64) buffer.getNumSamples());
+    performanceCounters.processBlockTime.recordSince(startTicks);
+
     // Audio passes through unchanged (oscilloscope is analysis-only)
 }
 
+void SCOPESCT002AudioProcessor::drainCapture(bool keep)
+{
+    const juce::ScopedTryLock sl(captureLock);
+
+    if (!sl.isLocked())
+        return;
+
+    if (keep)
+        captureFifo.read([this](const CaptureFifo::BlockView& block) { history.append(block); });
+    else
+        captureFifo.discardAll();
+}
+
+PerformanceCounters::Snapshot SCOPESCT002AudioProcessor::getPerformanceSnapshot() const
+{
+    auto snapshot = performanceCounters.getSnapshot();
+    snapshot.triggers = triggerEngine.getGeneration();
+    snapshot.droppedBlocks = captureFifo.getNumDroppedBlocks();
+    snapshot.samplesRecorded = recorder.getNumSamplesRecorded();
+    snapshot.samplesNotRecorded = recorder.getNumSamplesDropped();
+    return snapshot;
+}
+
 //==============================================================================
 bool SCOPESCT002AudioProcessor::hasEditor() const
 {
@@ -169,15 +312,24 @@ juce::AudioProcessorEditor* SCOPESCT002AudioProcessor::createEditor()
 //==============================================================================
 void SCOPESCT002AudioProcessor::getStateInformation (juce::MemoryBlock& destData)
 {
-    // You should use this method to store your parameters in the memory block.
-    // You could do that either as raw data, or use the XML or ValueTree classes
-    // as intermediaries to make it easy to save and load complex data.
+    juce::XmlElement state("SCOPESTATE");
+    state.setAttribute("captureSeconds", captureSeconds);
+    state.setAttribute("channelMask", juce::String::toHexString((juce::int64) getCaptureChannelMask()));
+    copyXmlToBinary(state, destData);
 }
 
 void SCOPESCT002AudioProcessor::setStateInformation (const void* data, int sizeInBytes)
 {
-    // You should use this method to restore your parameters from this memory block,
-    // whose contents will have been created by the getStateInformation() call.
+    if (auto state = getXmlFromBinary(data, sizeInBytes))
+    {
+        if (state->hasTagName("SCOPESTATE"))
+        {
+            setCaptureSeconds(state->getDoubleAttribute("captureSeconds", captureSeconds));
+
+            if (state->hasAttribute("channelMask"))
+                setCaptureChannelMask((juce::uint64) state->getStringAttribute("channelMask").getHexValue64());
+        }
+    }
 }
 
 //==============================================================================
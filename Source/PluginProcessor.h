@@ -9,6 +9,12 @@
 #pragma once
 
 #include <JuceHeader.h>
+#include "CaptureFifo.h"
+#include "ScopeHistory.h"
+#include "TriggerEngine.h"
+#include "PerformanceCounters.h"
+#include "CaptureRecorder.h"
+#include "MeasurementEngine.h"
 
 //==============================================================================
 /**
@@ -54,18 +60,108 @@ public:
     void setStateInformation (const void* data, int sizeInBytes) override;
 
     //==============================================================================
-    const float* getCircularBufferData(int channel) const { return circularBuffer.getReadPointer(channel); }
-    int getCircularBufferSize() const { return circularBuffer.getNumSamples(); }
-    int getCircularBufferPosition() const { return circularBufferPosition; }
+    /** Moves everything captured since the last call into the history, or throws
+        it away when keep is false. Call from a single consumer thread only (the
+        editor's render thread). Never blocks: does nothing while the capture is
+        being re-prepared.
+    */
+    void drainCapture(bool keep = true);
+
+    /** The captured signal as seen by the display. Only the consumer thread may
+        read it, and only while holding getCaptureLock().
+    */
+    const ScopeHistory& getHistory() const { return history; }
+    const juce::CriticalSection& getCaptureLock() const { return captureLock; }
+
+    /** Trigger settings can be changed from any thread. Queued triggers may only
+        be popped by the consumer thread while holding getCaptureLock().
+    */
+    TriggerEngine& getTriggerEngine() { return triggerEngine; }
+
+    /** Sets how much signal the history holds per channel. This reallocates, so
+        call it from the message thread, never the audio thread.
+    */
+    void setCaptureSeconds(double seconds);
+    double getCaptureSeconds() const { return captureSeconds; }
+
+    /** While tempo sync is on, the history also holds two of the longest synced
+        windows at the slowest tempo, so tempo changes never reallocate it:
+        maxTempoSyncBars bars of maxTempoSyncQuartersPerBar quarter notes at
+        minTempoSyncBpm. Longer bars are treated as that long. maxCaptureBytes
+        still applies, so with many channels the history may fall short; the
+        display says so when a synced window does not fit. Message thread only,
+        like setCaptureSeconds().
+    */
+    void setTempoSyncEnabled(bool shouldBeEnabled);
+    bool isTempoSyncEnabled() const { return tempoSyncEnabled; }
+
+    /** Timeline position one past the last captured sample. It only moves when
+        processBlock runs, so it doubles as a new-data generation counter.
+    */
+    juce::int64 getCaptureEndPosition() const { return captureEndPosition.load(std::memory_order_relaxed); }
+
+    /** Timeline position one past the last block with anything above silenceThreshold. */
+    juce::int64 getLastSoundPosition() const { return lastSoundPosition.load(std::memory_order_relaxed); }
+
+    juce::uint64 getNumDroppedCaptureBlocks() const { return captureFifo.getNumDroppedBlocks(); }
     double getSampleRate() const { return currentSampleRate; }
 
+    /** Number of input channels captured, fixed by the bus layout at prepareToPlay(). */
+    int getNumCaptureChannels() const { return numCaptureChannels.load(std::memory_order_relaxed); }
+
+    /** Which channels the audio thread copies into the capture. Disabled channels
+        cost nothing on the audio thread. Can be changed from any thread.
+    */
+    void setCaptureChannelMask(juce::uint64 mask) { captureChannelMask.store(mask, std::memory_order_relaxed); }
+    juce::uint64 getCaptureChannelMask() const { return captureChannelMask.load(std::memory_order_relaxed); }
+
+    /** Counters for the whole plugin. The editor's threads write their own
+        figures here too; any thread can read them.
+    */
+    PerformanceCounters& getPerformanceCounters() { return performanceCounters; }
+    const PerformanceCounters& getPerformanceCounters() const { return performanceCounters; }
+
+    /** Level and frequency of the trigger source channel, measured as it is
+        captured. Only one consumer may pop its results, and only while holding
+        getCaptureLock().
+    */
+    MeasurementEngine& getMeasurementEngine() { return measurementEngine; }
+
+    /** Streams the captured channels to disk. Start and stop it on the message
+        thread; prepareToPlay() stops it, since the file's format no longer fits.
+    */
+    CaptureRecorder& getRecorder() { return recorder; }
+
+    /** All the counters at once, including triggers, dropped capture blocks and recording. */
+    PerformanceCounters::Snapshot getPerformanceSnapshot() const;
+
+    static constexpr int maxCaptureChannels = CaptureFifo::maxChannels;
+    static constexpr double minCaptureSeconds = 0.1, maxCaptureSeconds = 120.0;
+    static constexpr juce::int64 maxCaptureBytes = (juce::int64) 512 << 20;
+    static constexpr double minTempoSyncBpm = 40.0;
+    static constexpr int maxTempoSyncBars = 4;
+    static constexpr double maxTempoSyncQuartersPerBar = 8.0; // 8/4 or 16/8; longer bars are clamped
+    static constexpr double maxTempoSyncQuarters = maxTempoSyncBars * maxTempoSyncQuartersPerBar;
+    static constexpr float silenceThreshold = 1.0e-5f; // -100 dBFS, far below a pixel at any zoom
+
 private:
     //==============================================================================
-    juce::AudioBuffer<float> circularBuffer;
-    int circularBufferPosition = 0;
+    void resizeHistory();
+    CaptureFifo::MusicalPosition getMusicalPosition() const;
+
+    CaptureFifo captureFifo;
+    TriggerEngine triggerEngine;
+    PerformanceCounters performanceCounters;
+    CaptureRecorder recorder;
+    MeasurementEngine measurementEngine;
+    ScopeHistory history;
+    juce::CriticalSection captureLock; // held by prepareToPlay and the consumer, never by the audio thread
+    std::atomic<juce::int64> captureEndPosition { 0 }, lastSoundPosition { 0 };
+    std::atomic<int> numCaptureChannels { 2 };
+    std::atomic<juce::uint64> captureChannelMask { ~(juce::uint64) 0 };
     double currentSampleRate = 44100.0;
-    
-    static constexpr int bufferSize = 4096;
+    double captureSeconds = 10.0;
+    bool tempoSyncEnabled = false;
     
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SCOPESCT002AudioProcessor)
 };
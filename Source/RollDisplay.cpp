@@ -0,0 +1,96 @@
+/*
+  ==============================================================================
+
+    This file contains the roll display, which scrolls the trace continuously
+    like a chart recorder for signals too slow to trigger on.
+
+  ==============================================================================
+*/
+
+#include "RollDisplay.h"
+#include "TraceRasterizer.h"
+
+//==============================================================================
+RollDisplay::RollDisplay()
+{
+    previousTops.malloc((size_t) CaptureFifo::maxChannels);
+    previousBottoms.malloc((size_t) CaptureFifo::maxChannels);
+}
+
+void RollDisplay::setSize(int newWidth, int newHeight)
+{
+    if (ring.setSize(newWidth, newHeight))
+        clear();
+}
+
+void RollDisplay::setSamplesPerColumn(double newSamplesPerColumn)
+{
+    if (newSamplesPerColumn == samplesPerColumn)
+        return;
+
+    samplesPerColumn = newSamplesPerColumn;
+    clear();
+}
+
+void RollDisplay::clear()
+{
+    ring.clear(juce::Colours::transparentBlack);
+    numPrevious = 0;
+    started = false;
+}
+
+void RollDisplay::restart(double time)
+{
+    clear();
+    nextColumnTime = time;
+    started = true;
+}
+
+//==============================================================================
+void RollDisplay::addColumn(const float* tops, const float* bottoms, const juce::Colour* colours, int numTraces)
+{
+    if (!ring.isValid())
+        return;
+
+    numTraces = juce::jmin(numTraces, CaptureFifo::maxChannels);
+
+    const auto x = ring.getWriteColumn();
+    juce::Image::BitmapData data(ring.getImage(), juce::Image::BitmapData::readWrite);
+    auto* column = data.getPixelPointer(x, 0);
+
+    // The column last held the oldest samples on screen
+    for (int y = 0; y < data.height; ++y)
+        reinterpret_cast<juce::PixelARGB*>(column + y * data.lineStride)->setARGB(0, 0, 0, 0);
+
+    for (int i = 0; i < numTraces; ++i)
+    {
+        auto top = tops[i], bottom = bottoms[i];
+        const bool wasCovered = i < numPrevious && previousTops[i] <= previousBottoms[i];
+        const auto previousTop = previousTops[i], previousBottom = previousBottoms[i];
+
+        previousTops[i] = top;
+        previousBottoms[i] = bottom;
+
+        if (top > bottom)
+            continue;
+
+        // Reach back to the previous column, so steep edges stay joined up
+        if (wasCovered)
+        {
+            top = juce::jmin(top, previousBottom);
+            bottom = juce::jmax(bottom, previousTop);
+        }
+
+        if (TraceColumns::finishSpan(top, bottom, data.height))
+            TraceRasterizer::fillSpan(data, x, top, bottom, colours[i].getPixelARGB());
+    }
+
+    numPrevious = numTraces;
+    ring.advance();
+    nextColumnTime += samplesPerColumn;
+}
+
+void RollDisplay::draw(juce::Graphics& g, int logicalWidth, int logicalHeight) const
+{
+    ring.draw(g, logicalWidth, logicalHeight);
+}
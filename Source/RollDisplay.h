@@ -0,0 +1,74 @@
+/*
+  ==============================================================================
+
+    This file contains the roll display, which scrolls the trace continuously
+    like a chart recorder for signals too slow to trigger on.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "CaptureFifo.h"
+#include "ColumnRing.h"
+
+//==============================================================================
+/**
+    A chart recorder: the newest signal on the right, one pixel column per
+    samplesPerColumn samples, scrolling left as it arrives.
+
+    Like the Spectrogram, the picture lives in a ColumnRing. Each column is
+    written once, from the min/max of every trace over its samples, with the
+    TraceRasterizer's span writer. A frame therefore costs only the columns
+    that arrived since the last one, whether the screen spans ten milliseconds
+    or a minute.
+
+    The caller keeps track of time through getNextColumnTime(), which each
+    addColumn() moves on by samplesPerColumn.
+*/
+class RollDisplay
+{
+public:
+    RollDisplay();
+
+    /** Sets the size in physical pixels. Clears if it changed. */
+    void setSize(int width, int height);
+
+    /** Sets how many samples each column covers. Clears if it changed. */
+    void setSamplesPerColumn(double samplesPerColumn);
+
+    int getWidth() const { return ring.getWidth(); }
+    int getHeight() const { return ring.getHeight(); }
+    double getSamplesPerColumn() const { return samplesPerColumn; }
+
+    /** Blanks every column and forgets where the roll had got to. */
+    void clear();
+
+    /** Blanks every column and starts again with the next column at time. */
+    void restart(double time);
+
+    /** False until restart() is called after a clear(). */
+    bool hasStarted() const { return started; }
+
+    /** The capture timeline position the next column starts at. */
+    double getNextColumnTime() const { return nextColumnTime; }
+
+    /** Writes the newest column: the rows each trace covers, from tops[i] down
+        to bottoms[i], with tops[i] > bottoms[i] for a trace with nothing to
+        show. Each trace is joined up to where it ended in the previous column.
+    */
+    void addColumn(const float* tops, const float* bottoms, const juce::Colour* colours, int numTraces);
+
+    /** Draws the columns, oldest first, filling the given logical area. */
+    void draw(juce::Graphics& g, int logicalWidth, int logicalHeight) const;
+
+private:
+    ColumnRing ring;
+    juce::HeapBlock<float> previousTops, previousBottoms; // per trace, where the last column left it
+    int numPrevious = 0;
+    double samplesPerColumn = 0.0, nextColumnTime = 0.0;
+    bool started = false;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(RollDisplay)
+};
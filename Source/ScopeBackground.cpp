@@ -0,0 +1,264 @@
+/*
+  ==============================================================================
+
+    This file contains the static layer of the scope display: background,
+    graticule, scale labels and trigger marker.
+
+  ==============================================================================
+*/
+
+#include "ScopeBackground.h"
+
+//==============================================================================
+void ScopeBackground::draw(juce::Graphics& g, const Layout& layout)
+{
+    if (layout.width <= 0 || layout.height <= 0)
+        return;
+
+    if (!isValid || layout != cachedLayout)
+    {
+        auto imageWidth = juce::jmax(1, juce::roundToInt(layout.width * layout.scale));
+        auto imageHeight = juce::jmax(1, juce::roundToInt(layout.height * layout.scale));
+
+        // Render() covers every pixel, so a same-sized image is simply painted over.
+        // A software image can be drawn on the render thread.
+        if (image.isNull() || image.getWidth() != imageWidth || image.getHeight() != imageHeight)
+            image = juce::Image(juce::Image::RGB, imageWidth, imageHeight, false, juce::SoftwareImageType());
+
+        juce::Graphics imageGraphics(image);
+        imageGraphics.addTransform(juce::AffineTransform::scale(layout.scale));
+        render(imageGraphics, layout);
+
+        cachedLayout = layout;
+        isValid = true;
+    }
+
+    g.drawImageTransformed(image, juce::AffineTransform::scale(1.0f / layout.scale));
+}
+
+void ScopeBackground::render(juce::Graphics& g, const Layout& layout)
+{
+    const int width = layout.width;
+    const int height = layout.height;
+
+    g.fillAll(juce::Colours::black);
+
+    if (layout.maxFrequency > 0.0)
+    {
+        renderSpectrumGrid(g, layout);
+        return;
+    }
+
+    if (layout.goniometer)
+    {
+        renderGoniometerGrid(g, layout);
+        return;
+    }
+
+    g.setColour(juce::Colours::darkgrey);
+    
+    // Vertical grid lines
+    if (layout.quartersShown > 0.0)
+    {
+        renderBeatGrid(g, layout);
+    }
+    else
+    {
+        for (int i = 1; i < numDivisionsX; ++i)
+        {
+            float x = width * i / (float) numDivisionsX;
+            g.drawVerticalLine(juce::roundToInt(x), 0.0f, (float)height);
+        }
+    }
+
+    g.setFont(11.0f);
+
+    if (layout.numLanes > 1)
+    {
+        // Stacked traces: a centre line per lane and a divider between lanes.
+        // The lanes are too short for amplitude labels to be readable.
+        for (int lane = 0; lane < layout.numLanes; ++lane)
+        {
+            auto top = height * lane / layout.numLanes;
+            auto bottom = height * (lane + 1) / layout.numLanes;
+
+            g.setColour(juce::Colours::darkgrey);
+            g.drawHorizontalLine((top + bottom) / 2, 0.0f, (float)width);
+
+            if (lane > 0)
+            {
+                g.setColour(juce::Colours::grey);
+                g.drawHorizontalLine(top, 0.0f, (float)width);
+            }
+        }
+
+        g.setColour(juce::Colours::grey);
+        g.drawVerticalLine(width / 2, 0.0f, (float)height);
+    }
+    else
+    {
+        // Horizontal grid lines
+        for (int i = 1; i < numDivisionsY; ++i)
+        {
+            float y = height * i / (float) numDivisionsY;
+            g.drawHorizontalLine(juce::roundToInt(y), 0.0f, (float)width);
+        }
+
+        // Center lines
+        g.setColour(juce::Colours::grey);
+        g.drawVerticalLine(width / 2, 0.0f, (float)height);
+        g.drawHorizontalLine(height / 2, 0.0f, (float)width);
+
+        // Amplitude of each horizontal line, matching the trace's mapping of
+        // y = centre - value * amplitudeScale * height * 0.4
+        for (int i = 1; i < numDivisionsY; ++i)
+        {
+            auto y = juce::roundToInt(height * i / (float) numDivisionsY);
+            auto value = (0.5f - i / (float) numDivisionsY) / (0.4f * layout.amplitudeScale);
+            g.drawText(juce::String(value, 2), 4, y - 14, 60, 14, juce::Justification::bottomLeft);
+        }
+    }
+
+    if (layout.quartersShown > 0.0)
+    {
+        g.drawText(juce::String(layout.bpm, 1) + " BPM", width - 124, height - 18, 120, 14, juce::Justification::bottomRight);
+    }
+    else if (layout.syncDoesNotFit)
+    {
+        g.drawText("Sync window exceeds capture memory", width - 244, height - 18, 240, 14, juce::Justification::bottomRight);
+    }
+    else if (layout.secondsPerDivision > 0.0)
+    {
+        auto seconds = layout.secondsPerDivision;
+        auto text = seconds >= 1.0   ? juce::String(seconds, 2) + " s/div"
+                  : seconds >= 1.0e-3 ? juce::String(seconds * 1.0e3, 2) + " ms/div"
+                                      : juce::String(seconds * 1.0e6, 1) + " us/div";
+        g.drawText(text, width - 124, height - 18, 120, 14, juce::Justification::bottomRight);
+    }
+
+    // Trigger level marker
+    if (layout.triggerY >= 0)
+    {
+        g.setColour(juce::Colours::red);
+        g.drawHorizontalLine(layout.triggerY, 0.0f, (float)width);
+    }
+}
+
+void ScopeBackground::renderBeatGrid(juce::Graphics& g, const Layout& layout)
+{
+    // A line per beat, or per quarter of the window when it is shorter than two
+    // beats. Frames start on bar lines, so whole bars put bar lines at whole
+    // multiples of the bar from the left edge.
+    const auto spacing = layout.quartersShown >= 2.0 * layout.quartersPerBeat ? layout.quartersPerBeat
+                                                                                : layout.quartersShown / 4.0;
+    const auto numLines = (int) std::floor(layout.quartersShown / spacing + 1.0e-6);
+    const auto showsWholeBars = std::abs(std::remainder(layout.quartersShown, layout.quartersPerBar)) < 1.0e-6;
+
+    for (int i = 1; i < numLines; ++i)
+    {
+        const auto quarters = i * spacing;
+        const auto isBarLine = showsWholeBars && std::abs(std::remainder(quarters, layout.quartersPerBar)) < 1.0e-6;
+
+        g.setColour(isBarLine ? juce::Colours::grey : juce::Colours::darkgrey);
+        g.drawVerticalLine(juce::roundToInt(layout.width * quarters / layout.quartersShown), 0.0f, (float) layout.height);
+    }
+
+    g.setColour(juce::Colours::darkgrey);
+}
+
+void ScopeBackground::renderSpectrumGrid(juce::Graphics& g, const Layout& layout)
+{
+    const int width = layout.width;
+    const int height = layout.height;
+    const auto logRange = std::log(layout.maxFrequency / layout.minFrequency);
+
+    g.setFont(11.0f);
+
+    // 1-2-5 frequency lines, labelled at each decade
+    for (double decade = 1.0; decade < layout.maxFrequency; decade *= 10.0)
+    {
+        for (auto multiple : { 1.0, 2.0, 5.0 })
+        {
+            auto frequency = decade * multiple;
+
+            if (frequency <= layout.minFrequency || frequency >= layout.maxFrequency)
+                continue;
+
+            auto x = juce::roundToInt(width * std::log(frequency / layout.minFrequency) / logRange);
+            g.setColour(multiple == 1.0 ? juce::Colours::grey : juce::Colours::darkgrey);
+            g.drawVerticalLine(x, 0.0f, (float)height);
+
+            if (multiple == 1.0)
+            {
+                auto text = frequency >= 1000.0 ? juce::String(juce::roundToInt(frequency / 1000.0)) + "k"
+                                                : juce::String(juce::roundToInt(frequency));
+                g.drawText(text, x + 3, height - 18, 40, 14, juce::Justification::bottomLeft);
+            }
+        }
+    }
+
+    // A level line every 12 dB
+    const auto decibelRange = layout.maxDecibels - layout.minDecibels;
+
+    for (auto decibels = layout.maxDecibels - 12.0f; decibels > layout.minDecibels; decibels -= 12.0f)
+    {
+        auto y = juce::roundToInt(height * (layout.maxDecibels - decibels) / decibelRange);
+
+        g.setColour(juce::Colours::darkgrey);
+        g.drawHorizontalLine(y, 0.0f, (float)width);
+
+        g.setColour(juce::Colours::grey);
+        g.drawText(juce::String(juce::roundToInt(decibels)) + " dB", 4, y - 14, 60, 14, juce::Justification::bottomLeft);
+    }
+}
+
+
+void ScopeBackground::renderGoniometerGrid(juce::Graphics& g, const Layout& layout)
+{
+    // Matches the goniometer's mapping: full scale at 80% of the radius of a
+    // square as big as the shorter side
+    const auto centre = juce::Point<float>(layout.width * 0.5f, layout.height * 0.5f);
+    const auto radius = juce::jmin(layout.width, layout.height) * 0.5f;
+    const auto fullScale = radius * 0.8f * layout.amplitudeScale;
+
+    g.setColour(juce::Colours::darkgrey);
+
+    for (auto level : { 0.25f, 0.5f, 0.75f, 1.0f })
+    {
+        auto r = fullScale * level;
+
+        if (r < radius)
+            g.drawEllipse(centre.x - r, centre.y - r, r * 2.0f, r * 2.0f, 1.0f);
+    }
+
+    // Diagonals, then the axes on top
+    auto diagonal = radius * juce::MathConstants<float>::sqrt2 * 0.5f;
+    g.drawLine(centre.x - diagonal, centre.y - diagonal, centre.x + diagonal, centre.y + diagonal);
+    g.drawLine(centre.x - diagonal, centre.y + diagonal, centre.x + diagonal, centre.y - diagonal);
+
+    g.setColour(juce::Colours::grey);
+    g.drawLine(centre.x - radius, centre.y, centre.x + radius, centre.y);
+    g.drawLine(centre.x, centre.y - radius, centre.x, centre.y + radius);
+
+    // Label the end of each channel's positive direction
+    g.setFont(11.0f);
+
+    auto label = [&](const juce::String& text, float x, float y)
+    {
+        g.drawText(text, juce::roundToInt(x) - 10, juce::roundToInt(y) - 7, 20, 14, juce::Justification::centred);
+    };
+
+    if (layout.midSide)
+    {
+        label("M", centre.x, centre.y - radius + 8.0f);
+        label("-S", centre.x - radius + 10.0f, centre.y - 9.0f);
+        label("+S", centre.x + radius - 10.0f, centre.y - 9.0f);
+        label("L", centre.x - diagonal + 8.0f, centre.y - diagonal + 8.0f);
+        label("R", centre.x + diagonal - 8.0f, centre.y - diagonal + 8.0f);
+    }
+    else
+    {
+        label("X", centre.x + radius - 10.0f, centre.y - 9.0f);
+        label("Y", centre.x + 10.0f, centre.y - radius + 8.0f);
+    }
+}
@@ -0,0 +1,90 @@
+/*
+  ==============================================================================
+
+    This file contains the static layer of the scope display: background,
+    graticule, scale labels and trigger marker.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+    Draws everything under the trace that only changes on a resize or a control
+    change. The layer is rendered once into an Image at the display's physical
+    resolution, so an ordinary frame costs a single opaque blit instead of a
+    fill, a dozen lines and a column of text.
+*/
+class ScopeBackground
+{
+public:
+    /** Everything the layer depends on. A change to any of it re-renders the cache. */
+    struct Layout
+    {
+        int width = 0, height = 0;
+        float scale = 1.0f;             // physical pixels per logical pixel
+        float amplitudeScale = 1.0f;
+        double secondsPerDivision = 0.0;
+        int triggerY = -1;              // -1 for no trigger marker
+        int numLanes = 1;               // more than one for stacked traces
+
+        // Synced to the host's tempo: lines on the beat instead of the divisions
+        double quartersShown = 0.0;     // 0 when not synced
+        double quartersPerBeat = 1.0, quartersPerBar = 4.0;
+        double bpm = 0.0;
+        bool syncDoesNotFit = false;    // synced, but the window is too long for the history
+
+        // A spectrum display has a log frequency axis and a dB axis instead
+        double minFrequency = 0.0, maxFrequency = 0.0; // 0 for the time domain
+        float minDecibels = -120.0f, maxDecibels = 0.0f;
+
+        // A goniometer has a square graticule in the middle instead
+        bool goniometer = false;
+        bool midSide = false;           // rotated 45 degrees
+
+        bool operator== (const Layout& other) const
+        {
+            return width == other.width && height == other.height && scale == other.scale
+                && amplitudeScale == other.amplitudeScale && secondsPerDivision == other.secondsPerDivision
+                && triggerY == other.triggerY && numLanes == other.numLanes
+                && quartersShown == other.quartersShown && quartersPerBeat == other.quartersPerBeat
+                && quartersPerBar == other.quartersPerBar && bpm == other.bpm
+                && syncDoesNotFit == other.syncDoesNotFit
+                && minFrequency == other.minFrequency && maxFrequency == other.maxFrequency
+                && minDecibels == other.minDecibels && maxDecibels == other.maxDecibels
+                && goniometer == other.goniometer && midSide == other.midSide;
+        }
+
+        bool operator!= (const Layout& other) const { return !operator== (other); }
+    };
+
+    static constexpr int numDivisionsX = 10;
+    static constexpr int numDivisionsY = 8;
+
+    ScopeBackground() = default;
+
+    /** Draws the layer at the origin of g, re-rendering the cache first if the
+        layout differs from the one it was made for.
+    */
+    void draw(juce::Graphics& g, const Layout& layout);
+
+    /** Forces the next draw() to re-render. */
+    void invalidate() { isValid = false; }
+
+    /** Draws the layer directly, without the cache. */
+    static void render(juce::Graphics& g, const Layout& layout);
+
+private:
+    static void renderBeatGrid(juce::Graphics& g, const Layout& layout);
+    static void renderSpectrumGrid(juce::Graphics& g, const Layout& layout);
+    static void renderGoniometerGrid(juce::Graphics& g, const Layout& layout);
+
+    juce::Image image;
+    Layout cachedLayout;
+    bool isValid = false;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ScopeBackground)
+};
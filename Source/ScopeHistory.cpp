@@ -0,0 +1,288 @@
+/*
+  ==============================================================================
+
+    This file contains the display-side copy of the captured signal.
+
+  ==============================================================================
+*/
+
+#include "ScopeHistory.h"
+
+namespace
+{
+    constexpr size_t pageSize = 4096;
+
+    float* allocatePages(size_t numFloats)
+    {
+        const auto numBytes = (numFloats * sizeof(float) + pageSize - 1) & ~(pageSize - 1);
+
+       #if JUCE_WINDOWS
+        auto* memory = _aligned_malloc(numBytes, pageSize);
+       #else
+        void* memory = nullptr;
+
+        if (posix_memalign(&memory, pageSize, numBytes) != 0)
+            memory = nullptr;
+       #endif
+
+        if (memory == nullptr)
+            throw std::bad_alloc();
+
+        return static_cast<float*>(memory);
+    }
+
+    void freePages(float* memory)
+    {
+       #if JUCE_WINDOWS
+        _aligned_free(memory);
+       #else
+        std::free(memory);
+       #endif
+    }
+}
+
+//==============================================================================
+ScopeHistory::Chunk::Chunk(int numChannels)
+    : memory(allocatePages((size_t) numChannels * chunkLength))
+{
+    juce::Array<float*> channels;
+
+    for (int channel = 0; channel < numChannels; ++channel)
+        channels.add(memory + (size_t) channel * chunkLength);
+
+    samples.setDataToReferTo(channels.getRawDataPointer(), numChannels, chunkLength);
+
+    // Writing every page now means the consumer never takes a page fault later
+    samples.clear();
+    pyramid.setSize(numChannels, chunkLength);
+}
+
+ScopeHistory::Chunk::~Chunk()
+{
+    freePages(memory);
+}
+
+//==============================================================================
+void ScopeHistory::setSize(int newNumChannels, juce::int64 capacityInSamples)
+{
+    newNumChannels = juce::jmax(newNumChannels, 1);
+    const auto numChunks = (int) juce::jmax((juce::int64) 2, (capacityInSamples + chunkLength - 1) / chunkLength);
+
+    if (newNumChannels != numChannels)
+    {
+        chunks.clear();
+        validFrom.calloc((size_t) newNumChannels);
+    }
+
+    numChannels = newNumChannels;
+
+    while (chunks.size() > numChunks)
+        chunks.remove(chunks.size() - 1);
+
+    while (chunks.size() < numChunks)
+        chunks.add(new Chunk(numChannels));
+
+    capacity = (juce::int64) numChunks * chunkLength;
+    clear();
+}
+
+void ScopeHistory::clear()
+{
+    // Only [startPosition, endPosition) is ever read, and every pyramid run inside
+    // that range was rebuilt after its last write, so stale samples can stay
+    startPosition = endPosition = 0;
+    publishedMask = 0;
+    musicalPosition = {};
+}
+
+void ScopeHistory::append(const CaptureFifo::BlockView& block)
+{
+    const auto& header = block.header;
+
+    if (header.position < endPosition || header.position - endPosition >= capacity)
+    {
+        // The producer restarted or we lost more than we can hold: start over
+        startPosition = endPosition = header.position;
+        publishedMask = 0;
+    }
+    else if (header.position > endPosition)
+    {
+        makeWritable(endPosition, header.position - endPosition);
+        clearRange(endPosition, header.position - endPosition);
+        updatePyramids(endPosition, header.position - endPosition);
+        endPosition = header.position;
+    }
+
+    if (header.musical.isValid)
+    {
+        musicalPosition = header.musical;
+        musicalPositionTime = header.position;
+    }
+
+    // Of a block longer than the history, only the newest samples can be kept
+    const int channelsToCopy = juce::jmin(numChannels, block.getNumChannels());
+    const int skip = (int) juce::jmax((juce::int64) 0, header.numSamples - capacity);
+    makeWritable(endPosition + skip, header.numSamples - skip);
+    const int runLengths[] = { block.getFirstRunLength(), block.getSecondRunLength() };
+
+    for (int channel = 0; channel < channelsToCopy; ++channel)
+    {
+        if (!block.isChannelPublished(channel))
+            continue;
+
+        // A newly enabled channel has nothing valid before this block
+        if ((publishedMask & CaptureFifo::getChannelBit(channel)) == 0)
+            validFrom[channel] = endPosition + skip;
+
+        const float* runs[] = { block.getFirstRun(channel), block.getSecondRun(channel) };
+        int offset = 0;
+
+        for (int run = 0; run < 2; ++run)
+        {
+            const int from = juce::jlimit(0, runLengths[run], skip - offset);
+            writeRun(channel, endPosition + offset + from, runs[run] + from, runLengths[run] - from);
+            offset += runLengths[run];
+        }
+    }
+
+    updatePyramids(endPosition + skip, header.numSamples - skip, header.channelMask);
+    endPosition += header.numSamples;
+    publishedMask = header.channelMask;
+}
+
+juce::Range<float> ScopeHistory::getMinMax(int channel, juce::int64 from, juce::int64 to) const
+{
+    jassert(from >= getStartPosition() && to <= endPosition);
+
+    if (from >= to)
+        return {};
+
+    auto lowest = std::numeric_limits<float>::max();
+    auto highest = std::numeric_limits<float>::lowest();
+
+    forEachChunkRun(from, to - from, [&](Chunk& chunk, int start, int length, int)
+    {
+        auto range = chunk.pyramid.getMinMax(chunk.samples, channel, start, start + length);
+        lowest = juce::jmin(lowest, range.getStart());
+        highest = juce::jmax(highest, range.getEnd());
+    });
+
+    return { lowest, highest };
+}
+
+void ScopeHistory::addMinMax(const int* channels, int numChannelsToRead, juce::int64 from, juce::int64 to,
+                             float* lowest, float* highest) const
+{
+    jassert(from >= getStartPosition() && to <= endPosition);
+
+    forEachChunkRun(from, to - from, [&](Chunk& chunk, int start, int length, int)
+    {
+        chunk.pyramid.addMinMax(chunk.samples, channels, numChannelsToRead, start, start + length, lowest, highest);
+    });
+}
+
+ScopeHistory::Snapshot::Ptr ScopeHistory::createSnapshot(juce::int64 from, juce::int64 to) const
+{
+    from = juce::jmax(from, getStartPosition());
+    to = juce::jmin(to, endPosition);
+
+    if (from >= to)
+        return nullptr;
+
+    Snapshot::Ptr snapshot(new Snapshot());
+    snapshot->numChannels = numChannels;
+    snapshot->startPosition = from;
+    snapshot->endPosition = to;
+    snapshot->firstChunk = from >> chunkBits;
+    snapshot->validFrom.malloc((size_t) numChannels);
+
+    for (int channel = 0; channel < numChannels; ++channel)
+        snapshot->validFrom[channel] = juce::jmax(from, getValidStart(channel));
+
+    for (auto chunkNumber = snapshot->firstChunk; chunkNumber <= (to - 1) >> chunkBits; ++chunkNumber)
+        snapshot->chunks.add(chunks.getObjectPointerUnchecked((int) (chunkNumber % chunks.size())));
+
+    return snapshot;
+}
+
+void ScopeHistory::Snapshot::addMinMax(const int* channels, int numChannelsToRead, juce::int64 from, juce::int64 to,
+                                       float* lowest, float* highest) const
+{
+    jassert(from >= startPosition && to <= endPosition);
+
+    forEachPiece(from, to - from, [&](juce::int64, int start, int length, int offset)
+    {
+        auto& chunk = getChunk(from + offset);
+        chunk.pyramid.addMinMax(chunk.samples, channels, numChannelsToRead, start, start + length, lowest, highest);
+    });
+}
+
+//==============================================================================
+void ScopeHistory::makeWritable(juce::int64 position, juce::int64 numSamples)
+{
+    if (numSamples <= 0)
+        return;
+
+    for (auto chunkNumber = position >> chunkBits; chunkNumber <= (position + numSamples - 1) >> chunkBits; ++chunkNumber)
+    {
+        const auto index = (int) (chunkNumber % chunks.size());
+        auto* pinned = chunks.getObjectPointerUnchecked(index);
+
+        if (pinned->getReferenceCount() == 1)
+            continue;
+
+        // A snapshot holds this chunk: carry on in a fresh one. Samples written
+        // to it this time round are still the newest in the history, so they
+        // come along; what is left of the previous time round is given up.
+        auto* fresh = new Chunk(numChannels);
+        const auto base = chunkNumber << chunkBits;
+        const auto keepFrom = juce::jmax(base, getStartPosition());
+        const auto keepTo = juce::jmin(position, endPosition);
+
+        if (keepTo > keepFrom)
+        {
+            const auto start = (int) (keepFrom - base);
+            const auto length = (int) (keepTo - keepFrom);
+
+            for (int channel = 0; channel < numChannels; ++channel)
+                juce::FloatVectorOperations::copy(fresh->samples.getWritePointer(channel, start),
+                                                  pinned->samples.getReadPointer(channel, start), length);
+
+            fresh->pyramid.update(fresh->samples, start, start + length);
+        }
+
+        startPosition = juce::jmax(startPosition, base + chunkLength - capacity);
+        chunks.set(index, fresh);
+    }
+}
+
+void ScopeHistory::writeRun(int channel, juce::int64 position, const float* source, int numSamples)
+{
+    forEachChunkRun(position, numSamples, [&](Chunk& chunk, int start, int length, int offset)
+    {
+        juce::FloatVectorOperations::copy(chunk.samples.getWritePointer(channel, start), source + offset, length);
+    });
+}
+
+void ScopeHistory::clearRange(juce::int64 position, juce::int64 numSamples)
+{
+    jassert(numSamples <= capacity);
+
+    for (int channel = 0; channel < numChannels; ++channel)
+    {
+        forEachChunkRun(position, numSamples, [&](Chunk& chunk, int start, int length, int)
+        {
+            juce::FloatVectorOperations::clear(chunk.samples.getWritePointer(channel, start), length);
+        });
+    }
+}
+
+void ScopeHistory::updatePyramids(juce::int64 position, juce::int64 numSamples, juce::uint64 channelMask)
+{
+    jassert(numSamples <= capacity);
+
+    forEachChunkRun(position, numSamples, [channelMask](Chunk& chunk, int start, int length, int)
+    {
+        chunk.pyramid.update(chunk.samples, start, start + length, channelMask);
+    });
+}
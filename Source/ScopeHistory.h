@@ -0,0 +1,234 @@
+/*
+  ==============================================================================
+
+    This file contains the display-side copy of the captured signal.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "CaptureFifo.h"
+#include "MinMaxPyramid.h"
+
+//==============================================================================
+/**
+    The most recent stretch of captured audio, owned by whichever thread drains
+    the CaptureFifo. Samples are addressed by their capture timeline position, so
+    positions reported by the audio thread can be looked up directly.
+
+    The ring is made of fixed-size, page-aligned chunks that are allocated and
+    touched up front by setSize(), so appending never allocates or faults in new
+    pages. Each chunk carries a MinMaxPyramid that is kept up to date as blocks
+    arrive, so the extremes of any range can be found without visiting every
+    sample in it, however deep the history is.
+
+    Chunks are reference counted so that a Snapshot can pin a stretch of the
+    history without copying it. Writing into a pinned chunk swaps in a fresh
+    one first, copy-on-write: only the part of the current chunk already
+    written this time round is copied, and the old samples the pinned chunk
+    still held drop out of the history a little early.
+*/
+class ScopeHistory
+{
+public:
+    static constexpr int chunkBits = 16;
+    static constexpr int chunkLength = 1 << chunkBits;
+
+    class Snapshot;
+
+    ScopeHistory() = default;
+
+    /** Resizes and clears. The capacity is rounded up to whole chunks, with at
+        least two. Chunks are reused where the channel count does not change.
+    */
+    void setSize(int numChannels, juce::int64 capacityInSamples);
+    void clear();
+
+    /** Appends a block drained from the CaptureFifo. Gaps left by dropped blocks
+        are filled with silence. Channels the block did not publish are left
+        untouched, pyramids included.
+    */
+    void append(const CaptureFifo::BlockView& block);
+
+    int getNumChannels() const { return numChannels; }
+    juce::int64 getCapacity() const { return capacity; }
+
+    /** Timeline position one past the newest sample. */
+    juce::int64 getEndPosition() const { return endPosition; }
+
+    /** Timeline position of the oldest sample still held. */
+    juce::int64 getStartPosition() const { return juce::jmax(startPosition, endPosition - capacity); }
+
+    bool isEmpty() const { return getStartPosition() >= endPosition; }
+
+    /** The musical position of the newest block the host tagged with one, and
+        the timeline position that block started at. The position is not valid
+        if no block has been tagged since the last clear().
+    */
+    const CaptureFifo::MusicalPosition& getMusicalPosition() const { return musicalPosition; }
+    juce::int64 getMusicalPositionTime() const { return musicalPositionTime; }
+
+    /** Timeline position of the oldest sample of a channel that was actually
+        captured: a channel that was disabled only holds stale samples from
+        before it was last enabled.
+    */
+    juce::int64 getValidStart(int channel) const { return juce::jmax(getStartPosition(), validFrom[channel]); }
+
+    /** Returns the sample at a timeline position between getStartPosition() and getEndPosition(). */
+    float getSample(int channel, juce::int64 position) const
+    {
+        return getChunk(position).samples.getSample(channel, (int) (position & (chunkLength - 1)));
+    }
+
+    /** Returns the smallest and largest sample of one channel in the timeline
+        range [from, to), which must lie within the history.
+    */
+    juce::Range<float> getMinMax(int channel, juce::int64 from, juce::int64 to) const;
+
+    /** Widens lowest[i] and highest[i] to take in the smallest and largest
+        sample of channels[i] in the timeline range [from, to), sharing the
+        pyramid lookups between the channels.
+    */
+    void addMinMax(const int* channels, int numChannels, juce::int64 from, juce::int64 to,
+                   float* lowest, float* highest) const;
+
+    /** Calls fn (const float* samples, int numSamples, juce::int64 position) for
+        each contiguous piece of one channel in the timeline range [from, to).
+    */
+    template <typename Fn>
+    void forEachRun(int channel, juce::int64 from, juce::int64 to, Fn&& fn) const
+    {
+        forEachChunkRun(from, to - from, [&](Chunk& chunk, int start, int length, int offset)
+        {
+            fn(chunk.samples.getReadPointer(channel, start), length, from + offset);
+        });
+    }
+
+    /** Pins the timeline range [from, to), clipped to what the history holds,
+        without copying it. Returns nullptr if nothing of it is left. The
+        snapshot keeps whole chunks, so it costs memory only once the history
+        would have overwritten them, and never more than the range rounded out
+        to chunks.
+    */
+    juce::ReferenceCountedObjectPtr<Snapshot> createSnapshot(juce::int64 from, juce::int64 to) const;
+
+private:
+    //==============================================================================
+    struct Chunk : public juce::ReferenceCountedObject
+    {
+        explicit Chunk(int numChannels);
+        ~Chunk() override;
+
+        float* memory = nullptr;
+        juce::AudioBuffer<float> samples; // refers to memory
+        MinMaxPyramid pyramid;
+
+        JUCE_DECLARE_NON_COPYABLE(Chunk)
+    };
+
+    Chunk& getChunk(juce::int64 position) const
+    {
+        return *chunks.getObjectPointerUnchecked((int) ((position >> chunkBits) % chunks.size()));
+    }
+
+    /** Calls fn (juce::int64 chunkNumber, int startInChunk, int length, int offset)
+        for each single-chunk piece of the timeline range [position, position + numSamples),
+        where chunkNumber counts chunks along the timeline.
+    */
+    template <typename Fn>
+    static void forEachPiece(juce::int64 position, juce::int64 numSamples, Fn&& fn)
+    {
+        for (juce::int64 offset = 0; offset < numSamples;)
+        {
+            const auto start = (int) ((position + offset) & (chunkLength - 1));
+            const auto length = (int) juce::jmin(numSamples - offset, (juce::int64) (chunkLength - start));
+            fn((position + offset) >> chunkBits, start, length, (int) offset);
+            offset += length;
+        }
+    }
+
+    /** Calls fn (Chunk&, int startInChunk, int length, int offset) for each
+        single-chunk piece of the timeline range [position, position + numSamples).
+    */
+    template <typename Fn>
+    void forEachChunkRun(juce::int64 position, juce::int64 numSamples, Fn&& fn) const
+    {
+        forEachPiece(position, numSamples, [&](juce::int64, int start, int length, int offset)
+        {
+            fn(getChunk(position + offset), start, length, offset);
+        });
+    }
+
+    void makeWritable(juce::int64 position, juce::int64 numSamples);
+    void writeRun(int channel, juce::int64 position, const float* source, int numSamples);
+    void clearRange(juce::int64 position, juce::int64 numSamples);
+    void updatePyramids(juce::int64 position, juce::int64 numSamples, juce::uint64 channelMask = ~(juce::uint64) 0);
+
+    juce::ReferenceCountedArray<Chunk> chunks;
+    int numChannels = 0;
+    juce::int64 capacity = 0;
+    juce::int64 startPosition = 0, endPosition = 0;
+    juce::HeapBlock<juce::int64> validFrom;  // per channel
+    juce::uint64 publishedMask = 0;          // channels the previous block published
+    CaptureFifo::MusicalPosition musicalPosition;
+    juce::int64 musicalPositionTime = 0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ScopeHistory)
+};
+
+//==============================================================================
+/**
+    A read-only stretch of a ScopeHistory, made by ScopeHistory::createSnapshot().
+
+    It shares the history's chunks rather than copying them, and reads the
+    same way as the history itself. Snapshots can be read and released on any
+    thread; the history they came from may carry on being written meanwhile.
+*/
+class ScopeHistory::Snapshot : public juce::ReferenceCountedObject
+{
+public:
+    using Ptr = juce::ReferenceCountedObjectPtr<Snapshot>;
+
+    int getNumChannels() const { return numChannels; }
+    juce::int64 getStartPosition() const { return startPosition; }
+    juce::int64 getEndPosition() const { return endPosition; }
+    juce::int64 getValidStart(int channel) const { return validFrom[channel]; }
+
+    float getSample(int channel, juce::int64 position) const
+    {
+        return getChunk(position).samples.getSample(channel, (int) (position & (chunkLength - 1)));
+    }
+
+    /** As ScopeHistory::addMinMax(). */
+    void addMinMax(const int* channels, int numChannelsToRead, juce::int64 from, juce::int64 to,
+                   float* lowest, float* highest) const;
+
+    /** As ScopeHistory::forEachRun(). */
+    template <typename Fn>
+    void forEachRun(int channel, juce::int64 from, juce::int64 to, Fn&& fn) const
+    {
+        forEachPiece(from, to - from, [&](juce::int64, int start, int length, int offset)
+        {
+            fn(getChunk(from + offset).samples.getReadPointer(channel, start), length, from + offset);
+        });
+    }
+
+private:
+    friend class ScopeHistory;
+    Snapshot() = default;
+
+    Chunk& getChunk(juce::int64 position) const
+    {
+        return *chunks.getObjectPointerUnchecked((int) ((position >> chunkBits) - firstChunk));
+    }
+
+    juce::ReferenceCountedArray<Chunk> chunks;  // from chunk number firstChunk on
+    juce::int64 firstChunk = 0;
+    juce::int64 startPosition = 0, endPosition = 0;
+    juce::HeapBlock<juce::int64> validFrom;    // per channel
+    int numChannels = 0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(Snapshot)
+};
@@ -0,0 +1,1144 @@
+/*
+  ==============================================================================
+
+    This file contains the scope's render thread, which prepares each display
+    frame away from the message thread.
+
+  ==============================================================================
+*/
+
+#include "ScopeRenderer.h"
+
+//==============================================================================
+ScopeRenderer::ScopeRenderer(SCOPESCT002AudioProcessor& proc)
+    : juce::Thread("Scope renderer"), processor(proc)
+{
+    pendingTriggers.ensureStorageAllocated(maxPendingTriggers);
+    phosphorSweeps.ensureStorageAllocated(maxPendingTriggers);
+
+    activeChannels.ensureStorageAllocated(SCOPESCT002AudioProcessor::maxCaptureChannels);
+    lowest.malloc((size_t) SCOPESCT002AudioProcessor::maxCaptureChannels);
+    highest.malloc((size_t) SCOPESCT002AudioProcessor::maxCaptureChannels);
+    validStarts.malloc((size_t) SCOPESCT002AudioProcessor::maxCaptureChannels);
+    goniometerX.malloc((size_t) maxGoniometerSamples);
+    goniometerY.malloc((size_t) maxGoniometerSamples);
+    difference.malloc((size_t) differenceBlockSize);
+    referenceBlock.malloc((size_t) differenceBlockSize + 1);
+    references.ensureStorageAllocated(maxReferences);
+
+    analyser.onFrame = [this](const float* power, int)
+    {
+        if (feedSpectrogram)
+            spectrogram.addFrame(power);
+    };
+}
+
+ScopeRenderer::~ScopeRenderer()
+{
+    stop();
+}
+
+void ScopeRenderer::start()
+{
+    if (!isThreadRunning())
+        startThread();
+}
+
+void ScopeRenderer::stop()
+{
+    signalThreadShouldExit();
+    notify();
+    stopThread(2000);
+}
+
+void ScopeRenderer::setSettings(const Settings& newSettings)
+{
+    const juce::SpinLock::ScopedLockType sl(settingsLock);
+    settings = newSettings;
+}
+
+void ScopeRenderer::setFrozen(bool shouldBeFrozen)
+{
+    frozen.store(shouldBeFrozen);
+}
+
+void ScopeRenderer::armSingleTrigger()
+{
+    rearmRequested.store(true);
+    frozen.store(false);
+    processor.getTriggerEngine().armSingle();
+}
+
+bool ScopeRenderer::renderFrameAndWait(int timeoutMilliseconds)
+{
+    frameFinished.reset();
+    requestFrame();
+    return frameFinished.wait(timeoutMilliseconds);
+}
+
+//==============================================================================
+void ScopeRenderer::drawFrame(juce::Graphics& g, int width, int height)
+{
+    const juce::ScopedLock sl(frameLock);
+    const auto& frame = frames[frontFrame];
+    const auto scale = frameScales[frontFrame];
+
+    newFrameAvailable.store(false);
+
+    // Until a frame of the new size is ready, whatever it does not cover stays black
+    if (frame.isNull() || juce::roundToInt(frame.getWidth() / scale) != width
+                       || juce::roundToInt(frame.getHeight() / scale) != height)
+        g.fillAll(juce::Colours::black);
+
+    if (frame.isValid())
+        g.drawImageTransformed(frame, juce::AffineTransform::scale(1.0f / scale));
+}
+
+//==============================================================================
+void ScopeRenderer::run()
+{
+    while (!threadShouldExit())
+    {
+        wait(-1);
+
+        if (threadShouldExit())
+            break;
+
+        renderFrame();
+    }
+}
+
+void ScopeRenderer::renderFrame()
+{
+    const auto startTicks = juce::Time::getHighResolutionTicks();
+    Settings current;
+
+    {
+        const juce::SpinLock::ScopedLockType sl(settingsLock);
+        current = settings;
+    }
+
+    if (current.width <= 0 || current.height <= 0)
+        return;
+
+    // The history belongs to this thread, but prepareToPlay may be resizing it
+    const juce::ScopedTryLock sl(processor.getCaptureLock());
+
+    if (!sl.isLocked())
+        return;
+
+    if (rearmRequested.exchange(false))
+    {
+        pendingTriggers.clearQuick();
+        hasTriggeredFrame = false;
+        heldFrame = nullptr;
+    }
+
+    if (!hasSettings || current.persistenceSeconds != lastSettings.persistenceSeconds)
+    {
+        phosphor.setPersistence(current.persistenceSeconds);
+        phosphor.clear();
+        phosphorSweeps.clearQuick();
+        lastPhosphorUpdate = 0.0;
+    }
+
+    // A different picture starts from blank, with the most recent audio
+    if (!hasSettings || current.mode != lastSettings.mode || current.midSide != lastSettings.midSide
+         || current.channelMask != lastSettings.channelMask || current.persistenceSeconds != lastSettings.persistenceSeconds)
+    {
+        goniometer.clear();
+        goniometerEnd = 0;
+        lastGoniometerUpdate = 0.0;
+    }
+
+    if (!hasSettings || current.mode != lastSettings.mode || current.channelMask != lastSettings.channelMask
+         || current.amplitudeScale != lastSettings.amplitudeScale || current.stacked != lastSettings.stacked)
+        roll.clear();
+
+    lastSettings = current;
+    hasSettings = true;
+
+    // Keep draining while frozen so the capture channel never fills up, but
+    // leave the history as it was so the frozen picture needs no copy
+    const bool isFrozenNow = frozen.load();
+    const bool shouldDraw = redrawRequested.exchange(false);
+    processor.drainCapture(!isFrozenNow);
+    const bool singleShotFrozen = consumeTriggers(current, isFrozenNow);
+
+    if (!isFrozenNow)
+        holdTriggeredFrame(current);
+
+    updateActiveChannels(current);
+    updateReferences(current);
+    samplesToDisplayShown.store(getSamplesToDisplay(current));
+
+    // The analysis keeps up with every drain, so that no frame is missed
+    // between the frames that get drawn
+    const bool showSpectrum = current.mode == DisplayMode::spectrum;
+    const bool showSpectrogram = current.mode == DisplayMode::spectrogram;
+
+    if ((showSpectrum || showSpectrogram) && !isFrozenNow)
+    {
+        analyser.setSettings(current.spectrum, processor.getSampleRate());
+
+        // Every analysed frame becomes a spectrogram column, one per physical pixel
+        if (showSpectrogram)
+        {
+            spectrogram.setSize(juce::roundToInt(current.width * current.scale), juce::roundToInt(current.height * current.scale));
+            spectrogram.setFormat(analyser.getSize(), processor.getSampleRate(), analyser.getPowerScale());
+        }
+
+        feedSpectrogram = showSpectrogram;
+        analyser.process(processor.getHistory(), activeChannels.begin(), activeChannels.size());
+    }
+
+    const bool showGoniometer = current.mode == DisplayMode::goniometer;
+
+    if (showGoniometer && !isFrozenNow)
+        updateGoniometer(current);
+
+    // A single shot's frame is drawn even on a drain-only pass, since the
+    // display is frozen from now on and it would otherwise never appear
+    if (!shouldDraw && !singleShotFrozen)
+        return;
+
+    const bool phosphorEnabled = current.persistenceSeconds > 0.0;
+
+    if (phosphorEnabled && current.mode == DisplayMode::scope && !isFrozenNow)
+        updatePhosphor(current);
+
+    if (current.periodLock && current.syncLength <= 0.0 && current.mode == DisplayMode::scope && !isFrozenNow)
+        updatePeriodLock(current);
+
+    //==============================================================================
+    auto& frame = frames[1 - frontFrame];
+    auto frameWidth = juce::jmax(1, juce::roundToInt(current.width * current.scale));
+    auto frameHeight = juce::jmax(1, juce::roundToInt(current.height * current.scale));
+
+    // The front frame may be mid-blit, but the back one is only ever touched here
+    if (frame.isNull() || frame.getWidth() != frameWidth || frame.getHeight() != frameHeight)
+        frame = juce::Image(juce::Image::RGB, frameWidth, frameHeight, false, juce::SoftwareImageType());
+
+    {
+        juce::Graphics g(frame);
+        g.addTransform(juce::AffineTransform::scale(current.scale));
+
+        // The scope's window is worked out first, since zooming changes the time labels
+        double startTime = 0.0;
+        int samplesToDisplay = getSamplesToDisplay(current);
+        const bool showTraces = current.mode == DisplayMode::scope && !phosphorEnabled;
+        const bool hasFrame = showTraces && getFrameStart(current, startTime, samplesToDisplay);
+        const bool isZoomed = hasFrame && (current.zoom != 1.0 || current.panSamples != 0.0);
+
+        // Static layers come from a cached image; only the traces are drawn afresh.
+        // The spectrogram covers the whole frame, so it needs no background.
+        if (!showSpectrogram)
+            background.draw(g, getBackgroundLayout(current, isZoomed ? samplesToDisplay : getSamplesToDisplay(current)));
+
+        if (showSpectrogram)
+        {
+            spectrogram.draw(g, current.width, current.height);
+        }
+        else if (showGoniometer)
+        {
+            // The square is at physical resolution, centred in the frame
+            goniometer.render();
+            auto side = goniometer.getSize() / current.scale;
+            g.drawImageTransformed(goniometer.getImage(), juce::AffineTransform::scale(1.0f / current.scale)
+                                                              .translated((current.width - side) * 0.5f, (current.height - side) * 0.5f));
+        }
+        else if (current.mode == DisplayMode::roll)
+        {
+            // Rolls on from the history, which stands still while frozen
+            if (!isFrozenNow)
+                updateRoll(current, frameWidth, frameHeight);
+
+            roll.draw(g, current.width, current.height);
+        }
+        else if (showSpectrum)
+        {
+            drawSpectrum(current, frameWidth, frameHeight);
+            g.drawImageTransformed(traceRasterizer.getImage(), juce::AffineTransform::scale(1.0f / current.scale));
+        }
+        else if (phosphorEnabled)
+        {
+            // The phosphor image is accumulated at logical resolution
+            g.drawImageAt(phosphor.getImage(), 0, 0);
+        }
+        else
+        {
+            // Traces are rasterized at the physical resolution and composited on top
+            traceRasterizer.setSize(frameWidth, frameHeight);
+            traceRasterizer.clear();
+
+            if (hasFrame)
+            {
+                // References underneath, zoomed and panned alike, as far as they reach
+                const bool showDifference = current.showDifference && !references.isEmpty() && !showsHeldFrame
+                                         && isFrameIn(*references.getLast().snapshot, references.getLast().startTime + viewShift, samplesToDisplay);
+
+                for (int r = 0; r < references.size() && !showDifference; ++r)
+                {
+                    const auto& reference = references.getReference(r);
+
+                    if (!isFrameIn(*reference.snapshot, reference.startTime + viewShift, samplesToDisplay))
+                        continue;
+
+                    buildTraces(current, *reference.snapshot, reference.startTime + viewShift, samplesToDisplay, frameWidth, frameHeight);
+
+                    for (int i = 0; i < activeChannels.size(); ++i)
+                        traceRasterizer.draw(*traces.getUnchecked(i), getReferenceColour(r));
+                }
+
+                if (showDifference)
+                    buildDifferenceTraces(current, references.getLast(), startTime, samplesToDisplay, frameWidth, frameHeight);
+                else if (showsHeldFrame)
+                    buildTraces(current, *heldFrame, startTime, samplesToDisplay, frameWidth, frameHeight);
+                else
+                    buildTraces(current, processor.getHistory(), startTime, samplesToDisplay, frameWidth, frameHeight);
+
+                for (int i = 0; i < activeChannels.size(); ++i)
+                    traceRasterizer.draw(*traces.getUnchecked(i), getTraceColour(activeChannels.getUnchecked(i)));
+            }
+
+            g.drawImageTransformed(traceRasterizer.getImage(), juce::AffineTransform::scale(1.0f / current.scale));
+        }
+    }
+
+    {
+        const juce::ScopedLock fl(frameLock);
+        frameScales[1 - frontFrame] = current.scale;
+        frontFrame = 1 - frontFrame;
+    }
+
+    auto& counters = processor.getPerformanceCounters();
+    counters.renderTime.recordSince(startTicks);
+    counters.framesRendered.add(1);
+
+    newFrameAvailable.store(true);
+    frameFinished.signal();
+}
+
+//==============================================================================
+ScopeBackground::Layout ScopeRenderer::getBackgroundLayout(const Settings& current, int samplesToDisplay) const
+{
+    ScopeBackground::Layout layout;
+    layout.width = current.width;
+    layout.height = current.height;
+    layout.scale = current.scale;
+    layout.amplitudeScale = current.amplitudeScale;
+    layout.numLanes = getNumLanes(current);
+    
+    if (current.mode == DisplayMode::goniometer)
+    {
+        layout.numLanes = 1;
+        layout.goniometer = true;
+        layout.midSide = current.midSide;
+        return layout;
+    }
+    
+    if (current.mode == DisplayMode::spectrum)
+    {
+        layout.numLanes = 1;
+        layout.minFrequency = SpectrumAnalyser::minFrequency;
+        layout.maxFrequency = processor.getSampleRate() * 0.5;
+        layout.minDecibels = SpectrumAnalyser::minDecibels;
+        layout.maxDecibels = SpectrumAnalyser::maxDecibels;
+        return layout;
+    }
+    
+    auto sampleRate = processor.getSampleRate();
+    
+    if (sampleRate > 0.0)
+        layout.secondsPerDivision = samplesToDisplay / (double) ScopeBackground::numDivisionsX / sampleRate;
+
+    // A synced frame gets beat lines, unless zoomed away from the synced window
+    const auto& musical = processor.getHistory().getMusicalPosition();
+    const bool isSynced = current.syncLength > 0.0;
+
+    // Laying windows end to end, the newest complete one starts up to two back
+    const auto syncedSamples = isSynced && musical.isValid ? getSamplesToDisplay(current) : 0;
+    layout.syncDoesNotFit = current.mode == DisplayMode::scope && 2 * (juce::int64) syncedSamples + 2 > processor.getHistory().getCapacity();
+
+    if (isSynced && musical.isValid && current.mode == DisplayMode::scope && samplesToDisplay == syncedSamples && !layout.syncDoesNotFit)
+    {
+        layout.quartersShown = getSyncQuarters(current, musical);
+        layout.quartersPerBeat = 4.0 / musical.denominator;
+        layout.quartersPerBar = musical.getQuartersPerBar();
+        layout.bpm = std::round(musical.bpm * 10.0) / 10.0;
+    }
+    
+    // When stacked, the marker goes in the trigger source's lane, if it is shown
+    auto triggerLane = current.stacked ? activeChannels.indexOf(processor.getTriggerEngine().getSourceChannel()) : 0;
+
+    if (current.triggerEnabled && !current.periodLock && !isSynced && current.mode == DisplayMode::scope && triggerLane >= 0)
+    {
+        auto lane = getLane(triggerLane, layout.numLanes, current.height);
+        layout.triggerY = juce::roundToInt(lane.getStart() + lane.getLength() * (0.5f - current.triggerLevel * current.amplitudeScale * 0.4f));
+    }
+    
+    return layout;
+}
+
+int ScopeRenderer::getSamplesToDisplay(const Settings& current) const
+{
+    // Synced frames last as long as their notes at the latest tempo; without a
+    // tempo from the host, the time scale applies as usual
+    const auto& musical = processor.getHistory().getMusicalPosition();
+
+    if (current.syncLength > 0.0 && musical.isValid)
+        return juce::jmax(1, juce::roundToInt(getSyncQuarters(current, musical) * 60.0 / musical.bpm * processor.getSampleRate()));
+
+    return juce::roundToInt(current.width * current.timeScale);
+}
+
+double ScopeRenderer::getSyncQuarters(const Settings& current, const CaptureFifo::MusicalPosition& musical)
+{
+    return current.syncBars ? current.syncLength * musical.getQuartersPerBar() : current.syncLength * 4.0;
+}
+
+bool ScopeRenderer::getTempoSyncedStart(const Settings& current, int samplesToDisplay, double& startTime) const
+{
+    const ScopeHistory& source = processor.getHistory();
+    const auto& musical = source.getMusicalPosition();
+
+    if (!musical.isValid || !musical.isPlaying)
+        return false;
+
+    // The newest tag maps quarter notes onto the timeline at its tempo. Frames
+    // are laid end to end from the bar line, and the newest complete one is shown.
+    const auto samplesPerQuarter = 60.0 / musical.bpm * processor.getSampleRate();
+    const auto windowQuarters = getSyncQuarters(current, musical);
+    const auto endQuarters = musical.ppq + (double) (source.getEndPosition() - 2 - source.getMusicalPositionTime()) / samplesPerQuarter;
+    const auto windowIndex = std::floor((endQuarters - musical.barStartPpq) / windowQuarters) - 1.0;
+    const auto windowStart = musical.barStartPpq + windowIndex * windowQuarters;
+    const auto time = (double) source.getMusicalPositionTime() + (windowStart - musical.ppq) * samplesPerQuarter;
+
+    if (!isFrameInHistory(time, samplesToDisplay))
+        return false;
+
+    startTime = time;
+    return true;
+}
+
+bool ScopeRenderer::getFrameStart(const Settings& current, double& startTime, int& samplesToDisplay)
+{
+    const ScopeHistory& source = processor.getHistory();
+    auto available = source.getEndPosition() - source.getStartPosition();
+    
+    // One spare sample at the end, so a fractional start still fills the screen
+    samplesToDisplay = (int) juce::jmin(available - 1, (juce::int64) getSamplesToDisplay(current));
+    
+    if (samplesToDisplay <= 0)
+        return false;
+    
+    startTime = (double) (source.getEndPosition() - samplesToDisplay - 1);
+    showsHeldFrame = false;
+    
+    if (current.syncLength > 0.0)
+    {
+        // Free running while the host is stopped or gives no tempo
+        getTempoSyncedStart(current, samplesToDisplay, startTime);
+    }
+    else if (current.periodLock)
+    {
+        // Free running until there is a clear period to lock to
+        if (hasLockedFrame && isFrameInHistory(lockedStartTime, samplesToDisplay))
+            startTime = lockedStartTime;
+    }
+    else if (current.triggerEnabled && !freeRunning)
+    {
+        // Show the latest triggered frame, from the history while it still
+        // holds all of it and from the held copy after that
+        if (!hasTriggeredFrame)
+            return false;
+
+        if (!isFrameInHistory(displayedTriggerTime, samplesToDisplay))
+        {
+            if (heldFrame == nullptr || !isFrameIn(*heldFrame, displayedTriggerTime, samplesToDisplay))
+                return false;
+
+            showsHeldFrame = true;
+        }
+        
+        startTime = displayedTriggerTime;
+    }
+    
+    viewShift = 0.0;
+
+    // The held copy only covers the frame, so it cannot be zoomed out of
+    if ((current.zoom != 1.0 || current.panSamples != 0.0) && !showsHeldFrame)
+    {
+        applyView(current, startTime, samplesToDisplay);
+    }
+    else
+    {
+        appliedZoom.store(1.0);
+        appliedPan.store(0.0);
+    }
+
+    return true;
+}
+
+void ScopeRenderer::applyView(const Settings& current, double& startTime, int& samplesToDisplay)
+{
+    // Any window within the history can be shown: the pyramid makes the cost
+    // follow the width however many samples each column covers
+    const ScopeHistory& source = processor.getHistory();
+    const auto available = (double) (source.getEndPosition() - source.getStartPosition() - 1);
+
+    if (available < minViewSamples)
+        return;
+
+    const auto centre = startTime + samplesToDisplay * 0.5 + current.panSamples;
+    const auto normalCentre = startTime + samplesToDisplay * 0.5;
+    const auto normalStart = startTime;
+
+    samplesToDisplay = (int) juce::jlimit((double) minViewSamples, available,
+                                          getSamplesToDisplay(current) / juce::jmax(1.0e-9, current.zoom));
+    startTime = juce::jlimit((double) source.getStartPosition(), (double) (source.getEndPosition() - samplesToDisplay - 1),
+                             centre - samplesToDisplay * 0.5);
+
+    viewShift = startTime - normalStart;
+    appliedZoom.store(getSamplesToDisplay(current) / (double) samplesToDisplay);
+    appliedPan.store(startTime + samplesToDisplay * 0.5 - normalCentre);
+}
+
+void ScopeRenderer::updateActiveChannels(const Settings& current)
+{
+    const auto numChannels = processor.getHistory().getNumChannels();
+
+    activeChannels.clearQuick();
+    activeChannelMask = 0;
+
+    for (int channel = 0; channel < numChannels; ++channel)
+    {
+        if ((current.channelMask & CaptureFifo::getChannelBit(channel)) != 0)
+        {
+            activeChannels.add(channel);
+            activeChannelMask |= CaptureFifo::getChannelBit(channel);
+        }
+    }
+
+    // Only allocates when more channels are shown than ever before
+    while (traces.size() < activeChannels.size())
+        traces.add(new TraceColumns());
+}
+
+juce::Colour ScopeRenderer::getTraceColour(int channel)
+{
+    if (channel == 0)
+        return juce::Colours::cyan;
+
+    if (channel == 1)
+        return juce::Colours::yellow;
+
+    // Further channels step round the hue circle by the golden ratio, so
+    // neighbouring channels stay distinct however many there are
+    return juce::Colour::fromHSV((float) std::fmod(0.5 + channel * 0.618034, 1.0), 0.7f, 1.0f, 1.0f);
+}
+
+float ScopeRenderer::getTraceY(const Settings& current, int index, int height, float sample) const
+{
+    // Stacked traces are mapped into, and kept inside, their own lanes
+    auto lane = getLane(current.stacked ? index : 0, getNumLanes(current), height);
+    auto y = lane.getStart() + lane.getLength() * (0.5f - sample * current.amplitudeScale * 0.4f);
+
+    return current.stacked ? juce::jlimit((float) lane.getStart(), (float) lane.getEnd(), y) : y;
+}
+
+template <typename Source>
+void ScopeRenderer::buildTraces(const Settings& current, const Source& source, double startTime, int samplesToDisplay, int width, int height)
+{
+    // Callers pass the target's own pixels, so HiDPI displays get a column per physical pixel
+    const auto numTraces = activeChannels.size();
+
+    for (int i = 0; i < numTraces; ++i)
+    {
+        traces.getUnchecked(i)->setSize(width, height);
+        validStarts[i] = source.getValidStart(activeChannels.getUnchecked(i));
+    }
+
+    if (numTraces == 0)
+        return;
+
+    auto toY = [&](int index, float sample) { return getTraceY(current, index, height, sample); };
+    auto samplesPerPixel = (double) samplesToDisplay / width;
+
+    if (samplesToDisplay <= width && current.sincInterpolation)
+    {
+        buildInterpolatedTraces(current, source, startTime, samplesToDisplay, width, height);
+    }
+    else if (samplesToDisplay <= width)
+    {
+        // Place samples relative to the sub-sample trigger time so the trace
+        // does not jitter by up to a sample from frame to frame
+        auto firstPosition = (juce::int64) std::floor(startTime);
+
+        for (int i = 0; i < numTraces; ++i)
+        {
+            auto channel = activeChannels.getUnchecked(i);
+            auto& trace = *traces.getUnchecked(i);
+            auto firstValid = juce::jmax(firstPosition, validStarts[i]);
+            float lastX = 0.0f, lastY = 0.0f;
+
+            for (auto position = firstValid; position <= firstPosition + samplesToDisplay + 1; ++position)
+            {
+                if (position >= source.getEndPosition())
+                    break;
+
+                float x = (float) (((double) position - startTime) / samplesPerPixel);
+                float y = toY(i, source.getSample(channel, position));
+
+                if (position > firstValid)
+                    trace.addLine(lastX, lastY, x, y);
+
+                lastX = x;
+                lastY = y;
+            }
+        }
+    }
+    else
+    {
+        // More samples than pixels: take each column's min/max envelope from the
+        // pyramid so no peak is skipped and the cost follows the width. One walk
+        // of the pyramid per column serves every channel.
+        for (int column = 0; column < width; ++column)
+        {
+            auto from = (juce::int64) std::floor(startTime + column * samplesPerPixel);
+            auto to = juce::jmax(from + 1, (juce::int64) std::floor(startTime + (column + 1) * samplesPerPixel));
+
+            juce::FloatVectorOperations::fill(lowest.get(), std::numeric_limits<float>::max(), numTraces);
+            juce::FloatVectorOperations::fill(highest.get(), std::numeric_limits<float>::lowest(), numTraces);
+            source.addMinMax(activeChannels.begin(), numTraces, from, to, lowest, highest);
+
+            for (int i = 0; i < numTraces; ++i)
+                if (from >= validStarts[i])
+                    traces.getUnchecked(i)->addSpan(column, toY(i, highest[i]), toY(i, lowest[i]));
+        }
+    }
+}
+
+template <typename Source>
+void ScopeRenderer::buildInterpolatedTraces(const Settings& current, const Source& source, double startTime,
+                                            int samplesToDisplay, int width, int height)
+{
+    // Every visible column gets the reconstructed waveform at a couple of
+    // points, so the cost follows the width and not the kernel's reach
+    const auto halfTaps = SincInterpolator::halfTaps;
+    const auto first = (juce::int64) std::floor(startTime) - halfTaps;
+    const auto numSamples = samplesToDisplay + 2 * halfTaps + 3;
+    const auto samplesPerPoint = (double) samplesToDisplay / (width * sincPointsPerColumn);
+
+    if (numSamples > sincInputSize)
+    {
+        sincInput.malloc((size_t) numSamples);
+        sincInputSize = numSamples;
+    }
+
+    for (int i = 0; i < activeChannels.size(); ++i)
+    {
+        const auto channel = activeChannels.getUnchecked(i);
+        const auto validStart = juce::jmax(validStarts[i], source.getStartPosition());
+        const auto validEnd = source.getEndPosition();
+
+        if (validStart >= validEnd)
+            continue;
+
+        // Beyond the ends of the valid samples, the nearest one stands in
+        for (int n = 0; n < numSamples; ++n)
+            sincInput[n] = source.getSample(channel, juce::jlimit(validStart, validEnd - 1, first + n));
+
+        auto& trace = *traces.getUnchecked(i);
+        float lastX = 0.0f, lastY = 0.0f;
+        bool hasLast = false;
+
+        for (int point = 0; point <= width * sincPointsPerColumn; ++point)
+        {
+            const auto time = startTime + point * samplesPerPoint;
+
+            if (time < (double) validStart || time > (double) (validEnd - 1))
+            {
+                hasLast = false;
+                continue;
+            }
+
+            const auto x = (float) point / sincPointsPerColumn;
+            const auto y = getTraceY(current, i, height, sincInterpolator.getValue(sincInput, time - (double) first));
+
+            if (hasLast)
+                trace.addLine(lastX, lastY, x, y);
+
+            lastX = x;
+            lastY = y;
+            hasLast = true;
+        }
+    }
+}
+
+void ScopeRenderer::updateRoll(const Settings& current, int width, int height)
+{
+    roll.setSize(width, height);
+    roll.setSamplesPerColumn(getSamplesToDisplay(current) / (double) roll.getWidth());
+
+    const ScopeHistory& source = processor.getHistory();
+    const auto samplesPerColumn = roll.getSamplesPerColumn();
+    const auto end = (double) source.getEndPosition();
+
+    // A fresh roll, or one too far behind to catch up by scrolling, is drawn
+    // afresh from the history a screen back; the pyramid keeps that O(width)
+    const auto screenStart = juce::jmax((double) source.getStartPosition(), end - 1.0 - roll.getWidth() * samplesPerColumn);
+
+    if (!roll.hasStarted() || roll.getNextColumnTime() < screenStart || roll.getNextColumnTime() > end)
+        roll.restart(screenStart);
+
+    const auto numTraces = activeChannels.size();
+    juce::Colour colours[CaptureFifo::maxChannels];
+
+    for (int i = 0; i < numTraces; ++i)
+    {
+        validStarts[i] = source.getValidStart(activeChannels.getUnchecked(i));
+        colours[i] = getTraceColour(activeChannels.getUnchecked(i));
+    }
+
+    // Only whole columns, each once, however the frames fall
+    while (roll.getNextColumnTime() + samplesPerColumn + 1.0 <= end)
+    {
+        const auto time = roll.getNextColumnTime();
+        const auto from = (juce::int64) std::floor(time);
+        const auto to = juce::jmax(from + 1, (juce::int64) std::floor(time + samplesPerColumn));
+
+        juce::FloatVectorOperations::fill(lowest.get(), std::numeric_limits<float>::max(), numTraces);
+        juce::FloatVectorOperations::fill(highest.get(), std::numeric_limits<float>::lowest(), numTraces);
+        source.addMinMax(activeChannels.begin(), numTraces, from, to, lowest, highest);
+
+        // Converted to rows in place: the highest sample is the top of the span
+        for (int i = 0; i < numTraces; ++i)
+        {
+            if (from >= validStarts[i])
+            {
+                highest[i] = getTraceY(current, i, height, highest[i]);
+                lowest[i] = getTraceY(current, i, height, lowest[i]);
+            }
+            else
+            {
+                highest[i] = 1.0f;
+                lowest[i] = 0.0f;
+            }
+        }
+
+        roll.addColumn(highest, lowest, colours, numTraces);
+    }
+}
+
+void ScopeRenderer::updateReferences(const Settings& current)
+{
+    const ScopeHistory& history = processor.getHistory();
+
+    // Letting go of a reference may free chunks, which is fine on this thread
+    if (clearReferencesRequested.exchange(false))
+        references.clearQuick();
+
+    // After prepareToPlay the channels may no longer line up
+    for (int r = references.size(); --r >= 0;)
+        if (references.getReference(r).snapshot->getNumChannels() != history.getNumChannels())
+            references.remove(r);
+
+    double startTime;
+    int samplesToDisplay;
+
+    if (addReferenceRequested.exchange(false) && getFrameStart(current, startTime, samplesToDisplay))
+    {
+        // Up to the newest sample: the chunks are pinned whole anyway, so this
+        // costs nothing extra and leaves room for zooming out afterwards
+        auto snapshot = showsHeldFrame ? heldFrame
+                                       : history.createSnapshot((juce::int64) std::floor(startTime), history.getEndPosition());
+
+        if (snapshot != nullptr)
+        {
+            if (references.size() >= maxReferences)
+                references.remove(0);
+
+            references.add({ snapshot, startTime });
+        }
+    }
+
+    numReferences.store(references.size());
+}
+
+void ScopeRenderer::buildDifferenceTraces(const Settings& current, const Reference& reference, double startTime,
+                                          int samplesToDisplay, int width, int height)
+{
+    const ScopeHistory& live = processor.getHistory();
+    const auto& snapshot = *reference.snapshot;
+    const auto numTraces = activeChannels.size();
+
+    // Live position p is compared with the reference at p + shift, which keeps
+    // the sub-sample part of both triggers: the reference is read between its
+    // samples, weighted by the fraction
+    const auto shift = reference.startTime - startTime;
+    const auto offset = (juce::int64) std::floor(shift);
+    const auto fraction = (float) (shift - (double) offset);
+
+    for (int i = 0; i < numTraces; ++i)
+    {
+        auto channel = activeChannels.getUnchecked(i);
+        traces.getUnchecked(i)->setSize(width, height);
+        validStarts[i] = juce::jmax(live.getValidStart(channel), snapshot.getValidStart(channel) - offset);
+    }
+
+    // The last live position with both reference samples it is read between
+    const auto endPosition = juce::jmin(live.getEndPosition(), snapshot.getEndPosition() - offset - 1);
+
+    auto getDifference = [&](int channel, juce::int64 position)
+    {
+        const auto before = snapshot.getSample(channel, position + offset);
+        const auto after = snapshot.getSample(channel, position + offset + 1);
+        return live.getSample(channel, position) - (before + (after - before) * fraction);
+    };
+
+    // Fills difference[0, numSamples) with live minus reference from a live position
+    auto subtract = [&](int channel, juce::int64 from, int numSamples)
+    {
+        live.forEachRun(channel, from, from + numSamples, [&](const float* samples, int length, juce::int64 position)
+        {
+            juce::FloatVectorOperations::copy(difference + (position - from), samples, length);
+        });
+
+        snapshot.forEachRun(channel, from + offset, from + offset + numSamples + 1, [&](const float* samples, int length, juce::int64 position)
+        {
+            juce::FloatVectorOperations::copy(referenceBlock + (position - offset - from), samples, length);
+        });
+
+        juce::FloatVectorOperations::subtractWithMultiply(difference.get(), referenceBlock.get(), 1.0f - fraction, numSamples);
+        juce::FloatVectorOperations::subtractWithMultiply(difference.get(), referenceBlock + 1, fraction, numSamples);
+    };
+
+    auto samplesPerPixel = (double) samplesToDisplay / width;
+
+    if (samplesToDisplay <= width)
+    {
+        auto firstPosition = (juce::int64) std::floor(startTime);
+        auto lastPosition = juce::jmin(firstPosition + samplesToDisplay + 2, endPosition);
+
+        for (int i = 0; i < numTraces; ++i)
+        {
+            auto& trace = *traces.getUnchecked(i);
+            auto firstValid = juce::jmax(firstPosition, validStarts[i]);
+            float lastX = 0.0f, lastY = 0.0f;
+
+            for (auto blockStart = firstValid; blockStart < lastPosition; blockStart += differenceBlockSize)
+            {
+                auto numSamples = (int) juce::jmin((juce::int64) differenceBlockSize, lastPosition - blockStart);
+                subtract(activeChannels.getUnchecked(i), blockStart, numSamples);
+
+                for (int k = 0; k < numSamples; ++k)
+                {
+                    auto position = blockStart + k;
+                    float x = (float) (((double) position - startTime) / samplesPerPixel);
+                    float y = getTraceY(current, i, height, difference[k]);
+
+                    if (position > firstValid)
+                        trace.addLine(lastX, lastY, x, y);
+
+                    lastX = x;
+                    lastY = y;
+                }
+            }
+        }
+    }
+    else
+    {
+        // No pyramid for a difference: each column's samples are subtracted and
+        // searched, up to maxDifferenceSamplesPerColumn of them spread evenly
+        // across it, so a long window costs no more than a frame's budget
+        for (int column = 0; column < width; ++column)
+        {
+            auto from = (juce::int64) std::floor(startTime + column * samplesPerPixel);
+            auto to = juce::jmin(endPosition, juce::jmax(from + 1, (juce::int64) std::floor(startTime + (column + 1) * samplesPerPixel)));
+
+            for (int i = 0; i < numTraces; ++i)
+            {
+                if (from < validStarts[i] || from >= to)
+                    continue;
+
+                const auto channel = activeChannels.getUnchecked(i);
+                auto lowestDifference = std::numeric_limits<float>::max();
+                auto highestDifference = std::numeric_limits<float>::lowest();
+
+                if (to - from <= maxDifferenceSamplesPerColumn)
+                {
+                    subtract(channel, from, (int) (to - from));
+                    auto range = juce::FloatVectorOperations::findMinAndMax(difference.get(), (int) (to - from));
+                    lowestDifference = range.getStart();
+                    highestDifference = range.getEnd();
+                }
+                else
+                {
+                    const auto step = (double) (to - from) / maxDifferenceSamplesPerColumn;
+
+                    for (int k = 0; k < maxDifferenceSamplesPerColumn; ++k)
+                    {
+                        auto value = getDifference(channel, from + (juce::int64) (k * step));
+                        lowestDifference = juce::jmin(lowestDifference, value);
+                        highestDifference = juce::jmax(highestDifference, value);
+                    }
+                }
+
+                traces.getUnchecked(i)->addSpan(column, getTraceY(current, i, height, highestDifference),
+                                                getTraceY(current, i, height, lowestDifference));
+            }
+        }
+    }
+}
+
+void ScopeRenderer::drawSpectrum(const Settings& current, int width, int height)
+{
+    traceRasterizer.setSize(width, height);
+    traceRasterizer.clear();
+    analyser.setDisplayWidth(width);
+
+    if (!analyser.hasSpectrum() || activeChannels.isEmpty())
+        return;
+
+    while (traces.size() < 2)
+        traces.add(new TraceColumns());
+
+    auto& averageTrace = *traces.getUnchecked(0);
+    auto& peakTrace = *traces.getUnchecked(1);
+    averageTrace.setSize(width, height);
+    peakTrace.setSize(width, height);
+
+    auto toY = [height](float decibels)
+    {
+        return height * (SpectrumAnalyser::maxDecibels - decibels) / (SpectrumAnalyser::maxDecibels - SpectrumAnalyser::minDecibels);
+    };
+
+    float lastAverage = 0.0f, lastPeak = 0.0f;
+
+    for (int x = 0; x < width; ++x)
+    {
+        float average, peak;
+        analyser.getColumnLevels(x, average, peak);
+
+        if (x > 0)
+        {
+            averageTrace.addLine((float) x - 0.5f, toY(lastAverage), (float) x + 0.5f, toY(average));
+            peakTrace.addLine((float) x - 0.5f, toY(lastPeak), (float) x + 0.5f, toY(peak));
+        }
+
+        lastAverage = average;
+        lastPeak = peak;
+    }
+
+    // Held peaks are drawn faintly behind the live spectrum
+    auto colour = getTraceColour(activeChannels.getFirst());
+    if (current.spectrum.peakHold)
+        traceRasterizer.draw(peakTrace, colour.withAlpha(0.4f));
+
+    traceRasterizer.draw(averageTrace, colour);
+}
+
+//==============================================================================
+void ScopeRenderer::updatePeriodLock(const Settings& current)
+{
+    // Enough signal for any period that fits on screen to repeat at least once
+    const auto& history = processor.getHistory();
+    const auto samplesToDisplay = getSamplesToDisplay(current);
+    const auto span = juce::jlimit(minPeriodLockSpan, maxPeriodLockSpan, samplesToDisplay * 2);
+
+    hasLockedFrame = periodTracker.process(history, processor.getTriggerEngine().getSourceChannel(), span);
+
+    if (hasLockedFrame)
+        lockedStartTime = periodTracker.getLockedStart((double) (history.getEndPosition() - samplesToDisplay - 1));
+}
+
+bool ScopeRenderer::consumeTriggers(const Settings& current, bool isFrozenNow)
+{
+    auto& triggerEngine = processor.getTriggerEngine();
+    TriggerEvent event;
+    
+    // While frozen, triggers are thrown away along with the audio they point at
+    while (triggerEngine.pop(event))
+        if (!isFrozenNow && pendingTriggers.size() < maxPendingTriggers)
+            pendingTriggers.add(event);
+    
+    if (isFrozenNow)
+        return false;
+    
+    // A frame is ready once a whole screen after its trigger has been captured.
+    // Only the newest ready frame is shown; older ones are skipped.
+    auto lastReadyPosition = processor.getHistory().getEndPosition() - getSamplesToDisplay(current) - 2;
+    int numReady = 0;
+    bool singleShotFrozen = false;
+    
+    while (numReady < pendingTriggers.size() && pendingTriggers.getReference(numReady).position <= lastReadyPosition)
+        ++numReady;
+    
+    if (numReady > 0)
+    {
+        // The phosphor display wants every one of them
+        if (current.persistenceSeconds > 0.0)
+            for (int i = 0; i < numReady && phosphorSweeps.size() < maxPendingTriggers; ++i)
+                phosphorSweeps.add(pendingTriggers.getReference(i).getTime());
+        
+        const auto& latest = pendingTriggers.getReference(numReady - 1);
+        displayedTriggerTime = latest.getTime();
+        lastTriggerTicks = latest.ticks;
+        hasTriggeredFrame = true;
+        heldFrame = nullptr;
+        pendingTriggers.removeRange(0, numReady);
+        
+        if (triggerEngine.getMode() == TriggerEngine::Mode::single)
+        {
+            frozen.store(true);
+            singleShotFired.store(true);
+            singleShotFrozen = true;
+        }
+    }
+    
+    auto secondsSinceTrigger = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - lastTriggerTicks);
+    freeRunning = triggerEngine.getMode() == TriggerEngine::Mode::automatic
+               && (!hasTriggeredFrame || secondsSinceTrigger > autoTimeoutSeconds);
+    
+    return singleShotFrozen;
+}
+
+void ScopeRenderer::holdTriggeredFrame(const Settings& current)
+{
+    // Pinned once, when the frame is three quarters of the way through the
+    // history: any earlier and a steady stream of triggers would keep paying
+    // for copy-on-write of the chunk being written
+    const ScopeHistory& history = processor.getHistory();
+
+    const auto samplesToDisplay = getSamplesToDisplay(current);
+
+    if (!hasTriggeredFrame || freeRunning || heldFrame != nullptr
+         || (double) history.getEndPosition() - displayedTriggerTime < history.getCapacity() * 0.75
+         || !isFrameInHistory(displayedTriggerTime, samplesToDisplay))
+        return;
+
+    // Only the frame: three quarters of a deep history is too much to keep twice
+    const auto from = (juce::int64) std::floor(displayedTriggerTime);
+    heldFrame = history.createSnapshot(from, from + samplesToDisplay + 2);
+}
+
+void ScopeRenderer::updatePhosphor(const Settings& current)
+{
+    auto now = juce::Time::getMillisecondCounterHiRes() * 0.001;
+    auto elapsed = lastPhosphorUpdate > 0.0 ? juce::jmin(0.5, now - lastPhosphorUpdate) : 0.0;
+    lastPhosphorUpdate = now;
+    
+    // Stacked lanes each get a layer, at no extra memory. Overlaid channels get
+    // a layer each up to a limit, past which they share a single white one.
+    const auto numTraces = activeChannels.size();
+    const auto numLayers = current.stacked || numTraces <= maxOverlaidPhosphorLayers ? numTraces : 1;
+
+    if (phosphor.getWidth() != current.width || phosphor.getHeight() != current.height
+         || phosphor.isStacked() != current.stacked || phosphorChannelMask != activeChannelMask)
+    {
+        phosphor.setSize(numLayers, current.width, current.height, current.stacked);
+        phosphorChannelMask = activeChannelMask;
+
+        if (numLayers == numTraces)
+            for (int i = 0; i < numTraces; ++i)
+                phosphor.setColour(i, getTraceColour(activeChannels.getUnchecked(i)));
+    }
+    
+    phosphor.decay(elapsed);
+    
+    double startTime;
+    int samplesToDisplay;
+    
+    // Free-running, each frame is one sweep of the latest audio
+    if (!current.triggerEnabled || freeRunning)
+    {
+        phosphorSweeps.clearQuick();
+        
+        if (getFrameStart(current, startTime, samplesToDisplay))
+            phosphorSweeps.add(startTime);
+    }
+    
+    auto numSweeps = phosphorSweeps.size();
+    
+    if (numSweeps > 0 && getFrameStart(current, startTime, samplesToDisplay))
+    {
+        // Draw as many sweeps as last frame's cost says fit in the budget,
+        // evenly spread, each standing in for the ones skipped around it
+        auto affordable = secondsPerSweep > 0.0 ? (int) (phosphorBudgetSeconds / secondsPerSweep) : maxSweepsPerFrame;
+        auto numToDraw = juce::jlimit(1, juce::jmin(numSweeps, maxSweepsPerFrame), affordable);
+        auto weight = numSweeps / (float) numToDraw;
+        auto started = juce::Time::getMillisecondCounterHiRes();
+        
+        for (int i = 0; i < numToDraw; ++i)
+        {
+            auto sweepStart = phosphorSweeps.getUnchecked((int) ((i + 0.5) * numSweeps / numToDraw));
+            
+            if (!isFrameInHistory(sweepStart, samplesToDisplay))
+                continue;
+            
+            buildTraces(current, processor.getHistory(), sweepStart, samplesToDisplay, current.width, current.height);
+
+            for (int trace = 0; trace < numTraces; ++trace)
+            {
+                auto layer = numLayers == numTraces ? trace : 0;
+                phosphor.addSweep(layer, *traces.getUnchecked(trace), weight, layer == trace);
+            }
+        }
+        
+        auto seconds = (juce::Time::getMillisecondCounterHiRes() - started) * 0.001 / numToDraw;
+        secondsPerSweep = secondsPerSweep > 0.0 ? 0.8 * secondsPerSweep + 0.2 * seconds : seconds;
+    }
+    
+    phosphorSweeps.clearQuick();
+    phosphor.render();
+}
+
+void ScopeRenderer::updateGoniometer(const Settings& current)
+{
+    const ScopeHistory& source = processor.getHistory();
+
+    auto now = juce::Time::getMillisecondCounterHiRes() * 0.001;
+    auto elapsed = lastGoniometerUpdate > 0.0 ? juce::jmin(0.5, now - lastGoniometerUpdate) : 0.0;
+    lastGoniometerUpdate = now;
+
+    goniometer.setSize(juce::roundToInt(juce::jmin(current.width, current.height) * current.scale));
+    goniometer.setPersistence(current.persistenceSeconds > 0.0 ? current.persistenceSeconds : defaultGoniometerPersistence);
+    goniometer.decay(elapsed);
+
+    // The history starts again from zero after prepareToPlay
+    auto end = source.getEndPosition();
+
+    if (goniometerEnd > end)
+        goniometerEnd = 0;
+
+    if (activeChannels.isEmpty())
+    {
+        goniometerEnd = end;
+        return;
+    }
+
+    // The first two channels shown, or one against itself
+    auto xChannel = activeChannels.getFirst();
+    auto yChannel = activeChannels.size() > 1 ? activeChannels.getUnchecked(1) : xChannel;
+    auto start = juce::jmax(goniometerEnd, end - maxGoniometerSamples, source.getStartPosition());
+    start = juce::jmax(start, source.getValidStart(xChannel), source.getValidStart(yChannel));
+    goniometerEnd = end;
+
+    if (start >= end)
+        return;
+
+    source.forEachRun(xChannel, start, end, [&](const float* samples, int numSamples, juce::int64 position)
+    {
+        juce::FloatVectorOperations::copy(goniometerX + (position - start), samples, numSamples);
+    });
+
+    source.forEachRun(yChannel, start, end, [&](const float* samples, int numSamples, juce::int64 position)
+    {
+        juce::FloatVectorOperations::copy(goniometerY + (position - start), samples, numSamples);
+    });
+
+    goniometer.setColour(getTraceColour(xChannel));
+    goniometer.addSamples(goniometerX, goniometerY, (int) (end - start),
+                          current.midSide ? Goniometer::Mode::midSide : Goniometer::Mode::xy, current.amplitudeScale);
+}
@@ -0,0 +1,313 @@
+/*
+  ==============================================================================
+
+    This file contains the scope's render thread, which prepares each display
+    frame away from the message thread.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "PluginProcessor.h"
+#include "ScopeBackground.h"
+#include "TraceRasterizer.h"
+#include "PhosphorDisplay.h"
+#include "SpectrumAnalyser.h"
+#include "Spectrogram.h"
+#include "Goniometer.h"
+#include "PeriodTracker.h"
+#include "RollDisplay.h"
+#include "SincInterpolator.h"
+
+//==============================================================================
+/**
+    Builds complete display frames on a dedicated thread.
+
+    Each time requestFrame() is called, the thread drains the capture, consumes
+    queued triggers, draws the background and traces into the back buffer of a
+    pair of software images and swaps it to the front. requestDrain() does the
+    first two only, to keep the capture flowing while nothing needs redrawing.
+    The component's paint() is then just drawFrame(), a single blit of the
+    front image, so a busy host UI cannot make a frame late and a slow frame
+    cannot stall the host.
+
+    Settings are handed over as a whole under a spin lock and take effect from
+    the next frame.
+*/
+class ScopeRenderer : private juce::Thread
+{
+public:
+    enum class DisplayMode
+    {
+        scope = 0,  // the signal against time
+        spectrum,   // its magnitude spectrum against log frequency
+        spectrogram, // a scrolling history of its spectrum
+        goniometer, // one channel against another
+        roll        // the signal scrolling past continuously, like a chart recorder
+    };
+
+    /** Everything the message thread controls about the picture. */
+    struct Settings
+    {
+        DisplayMode mode = DisplayMode::scope;
+        int width = 0, height = 0;     // logical pixels
+        float scale = 1.0f;            // physical pixels per logical pixel
+        float timeScale = 1.0f;
+        float amplitudeScale = 1.0f;
+        float triggerLevel = 0.0f;
+        juce::uint64 channelMask = ~(juce::uint64) 0; // channels shown, see CaptureFifo::getChannelBit()
+        bool stacked = false;          // a lane per channel instead of overlaid traces
+        bool midSide = false;          // goniometer rotated to show mid and side
+        bool showDifference = false;   // live minus the newest reference trace, instead of the live trace
+        double zoom = 1.0;             // the time scale divided by this...
+        double panSamples = 0.0;       // ...and the window's centre moved by this, from the frame it would show
+        double persistenceSeconds = 0.0;
+        bool triggerEnabled = true;
+        bool periodLock = false;       // frames aligned to the signal's period instead of to triggers
+        double syncLength = 0.0;       // frames of this many whole notes, or bars, on the host's tempo; 0 for the time scale
+        bool syncBars = false;
+        bool sincInterpolation = false; // the reconstructed waveform between samples, instead of straight lines
+        SpectrumAnalyser::Settings spectrum;
+
+        bool operator== (const Settings& other) const
+        {
+            return mode == other.mode && spectrum == other.spectrum
+                && width == other.width && height == other.height && scale == other.scale
+                && timeScale == other.timeScale && amplitudeScale == other.amplitudeScale
+                && triggerLevel == other.triggerLevel && channelMask == other.channelMask && stacked == other.stacked
+                && midSide == other.midSide && showDifference == other.showDifference
+                && zoom == other.zoom && panSamples == other.panSamples
+                && persistenceSeconds == other.persistenceSeconds && triggerEnabled == other.triggerEnabled
+                && periodLock == other.periodLock && syncLength == other.syncLength && syncBars == other.syncBars
+                && sincInterpolation == other.sincInterpolation;
+        }
+
+        bool operator!= (const Settings& other) const { return !operator== (other); }
+    };
+
+    explicit ScopeRenderer(SCOPESCT002AudioProcessor& processor);
+    ~ScopeRenderer() override;
+
+    void start();
+    void stop();
+
+    void setSettings(const Settings& newSettings);
+
+    /** Wakes the thread to prepare the next frame, if it is not still busy. */
+    void requestFrame()
+    {
+        // Still set means the thread has not even started on the last one
+        if (redrawRequested.exchange(true))
+            processor.getPerformanceCounters().framesSkipped.add(1);
+
+        notify();
+    }
+
+    /** Wakes the thread to drain the capture and consume triggers without drawing,
+        unless a single-shot trigger needs its frame drawn.
+    */
+    void requestDrain() { notify(); }
+
+    /** Requests a frame and blocks until one has been finished, for offline use
+        such as the benchmarks. Returns false if none was finished in time.
+    */
+    bool renderFrameAndWait(int timeoutMilliseconds);
+
+    /** A frozen display keeps draining but leaves the history and picture alone. */
+    void setFrozen(bool shouldBeFrozen);
+    bool isFrozen() const { return frozen.load(); }
+
+    /** Forgets the current triggered frame and lets the next single trigger through. */
+    void armSingleTrigger();
+
+    /** Keeps the frame on screen as a reference trace, drawn under the live one
+        in the scope display. References pin the history's chunks rather than
+        copying them; beyond maxReferences the oldest is dropped.
+    */
+    void addReference() { addReferenceRequested.store(true); }
+    void clearReferences() { clearReferencesRequested.store(true); }
+    int getNumReferences() const { return numReferences.load(); }
+
+    /** The zoom and pan the last scope frame was drawn with, once limited to
+        what the history holds. Zooming and panning from these rather than from
+        the requested values means pushing past an end does not build up.
+    */
+    double getAppliedZoom() const { return appliedZoom.load(); }
+    double getAppliedPan() const { return appliedPan.load(); }
+
+    /** How many samples a screen holds before any zoom, as of the last pass:
+        the time scale, or a synced window at the host's tempo. 0 before the
+        first pass.
+    */
+    int getSamplesToDisplay() const { return samplesToDisplayShown.load(); }
+
+    /** Returns true once each time a single-shot trigger has frozen the display. */
+    bool checkSingleShotFired() { return singleShotFired.exchange(false); }
+
+    //==============================================================================
+    /** Message thread: true if a frame has been finished since the last drawFrame(). */
+    bool isNewFrameAvailable() const { return newFrameAvailable.load(); }
+
+    /** Message thread: blits the latest finished frame over the given logical area. */
+    void drawFrame(juce::Graphics& g, int width, int height);
+
+private:
+    //==============================================================================
+    void run() override;
+    void renderFrame();
+
+    ScopeBackground::Layout getBackgroundLayout(const Settings& current, int samplesToDisplay) const;
+    void updateActiveChannels(const Settings& current);
+    int getNumLanes(const Settings& current) const { return current.stacked ? juce::jmax(1, activeChannels.size()) : 1; }
+    static juce::Range<int> getLane(int lane, int numLanes, int height) { return { height * lane / numLanes, height * (lane + 1) / numLanes }; }
+    static juce::Colour getTraceColour(int channel);
+
+    int getSamplesToDisplay(const Settings& current) const;
+    static double getSyncQuarters(const Settings& current, const CaptureFifo::MusicalPosition& musical);
+    bool getFrameStart(const Settings& current, double& startTime, int& samplesToDisplay);
+    bool getTempoSyncedStart(const Settings& current, int samplesToDisplay, double& startTime) const;
+    void applyView(const Settings& current, double& startTime, int& samplesToDisplay);
+    bool isFrameInHistory(double startTime, int samplesToDisplay) const { return isFrameIn(processor.getHistory(), startTime, samplesToDisplay); }
+
+    template <typename Source>
+    static bool isFrameIn(const Source& source, double startTime, int samplesToDisplay)
+    {
+        return startTime >= (double) source.getStartPosition()
+            && startTime + samplesToDisplay < (double) source.getEndPosition();
+    }
+
+    bool consumeTriggers(const Settings& current, bool isFrozenNow);
+    void holdTriggeredFrame(const Settings& current);
+    void updatePeriodLock(const Settings& current);
+    void updatePhosphor(const Settings& current);
+    float getTraceY(const Settings& current, int index, int height, float sample) const;
+
+    /** Source is a ScopeHistory or a ScopeHistory::Snapshot. */
+    template <typename Source>
+    void buildTraces(const Settings& current, const Source& source, double startTime, int samplesToDisplay, int width, int height);
+    template <typename Source>
+    void buildInterpolatedTraces(const Settings& current, const Source& source, double startTime, int samplesToDisplay, int width, int height);
+    void drawSpectrum(const Settings& current, int width, int height);
+    void updateGoniometer(const Settings& current);
+    void updateRoll(const Settings& current, int width, int height);
+
+    //==============================================================================
+    SCOPESCT002AudioProcessor& processor;
+
+    juce::SpinLock settingsLock;
+    Settings settings;
+
+    std::atomic<bool> frozen { false }, rearmRequested { false }, singleShotFired { false };
+    std::atomic<bool> redrawRequested { false };
+
+    // Double-buffered frames. The render thread draws into the back one and
+    // swaps under frameLock, which drawFrame() holds while blitting the front.
+    juce::CriticalSection frameLock;
+    juce::Image frames[2];
+    float frameScales[2] = { 1.0f, 1.0f };
+    int frontFrame = 0;
+    std::atomic<bool> newFrameAvailable { false };
+    juce::WaitableEvent frameFinished;
+
+    //==============================================================================
+    // Render thread only
+    Settings lastSettings;
+    bool hasSettings = false;
+
+    ScopeBackground background;
+    TraceRasterizer traceRasterizer;
+
+    // The channels shown, and a trace for each. The min/max of every shown
+    // channel is gathered in a single pass over the history per column.
+    juce::Array<int> activeChannels;
+    juce::uint64 activeChannelMask = 0;
+    juce::OwnedArray<TraceColumns> traces;
+    juce::HeapBlock<float> lowest, highest;
+    juce::HeapBlock<juce::int64> validStarts;
+
+    // Zoomed in, with sinc interpolation: the samples under the frame and a
+    // kernel's reach either side, for one channel at a time
+    SincInterpolator sincInterpolator;
+    juce::HeapBlock<float> sincInput;
+    int sincInputSize = 0;
+
+    // Reference traces, each pinning the frame it was taken from. The
+    // difference view compares the live frame with the newest of them.
+    struct Reference
+    {
+        ScopeHistory::Snapshot::Ptr snapshot;
+        double startTime = 0.0;
+    };
+
+    juce::Array<Reference> references;
+    std::atomic<bool> addReferenceRequested { false }, clearReferencesRequested { false };
+    std::atomic<int> numReferences { 0 };
+    juce::HeapBlock<float> difference, referenceBlock;
+
+    void updateReferences(const Settings& current);
+    void buildDifferenceTraces(const Settings& current, const Reference& reference, double startTime,
+                               int samplesToDisplay, int width, int height);
+    static juce::Colour getReferenceColour(int index) { return juce::Colours::white.withAlpha(0.55f - 0.1f * index); }
+
+    // Triggers queued by the audio thread whose frames have not fully arrived yet
+    juce::Array<TriggerEvent> pendingTriggers;
+    double displayedTriggerTime = 0.0;
+    juce::int64 lastTriggerTicks = 0;
+    bool hasTriggeredFrame = false;
+    bool freeRunning = true;
+
+    // The triggered frame, pinned before the history lets go of it, so that
+    // Normal mode keeps showing it however long the next trigger takes
+    ScopeHistory::Snapshot::Ptr heldFrame;
+    bool showsHeldFrame = false;   // the last getFrameStart() fell back on it
+
+    // Period lock: where the latest frame in phase with the signal starts
+    PeriodTracker periodTracker;
+    double lockedStartTime = 0.0;
+    bool hasLockedFrame = false;
+
+    // Zoom and pan: how far getFrameStart() moved the start of the last frame
+    std::atomic<double> appliedZoom { 1.0 }, appliedPan { 0.0 };
+    std::atomic<int> samplesToDisplayShown { 0 };
+    double viewShift = 0.0;
+
+    // Digital phosphor mode: each triggered sweep is accumulated rather than
+    // only the latest being shown, within a fixed time budget per frame
+    PhosphorDisplay phosphor;
+    juce::uint64 phosphorChannelMask = 0;
+    juce::Array<double> phosphorSweeps;
+    double secondsPerSweep = 0.0;
+    double lastPhosphorUpdate = 0.0;
+
+    // Spectrum and spectrogram modes: analysed here, since this thread owns the history
+    SpectrumAnalyser analyser;
+    Spectrogram spectrogram;
+    bool feedSpectrogram = false;
+
+    // Goniometer mode: every sample pair since the last pass is binned, drawn or not
+    Goniometer goniometer;
+    juce::HeapBlock<float> goniometerX, goniometerY;
+    juce::int64 goniometerEnd = 0;
+    double lastGoniometerUpdate = 0.0;
+
+    // Roll mode: only the columns completed since the last frame are added
+    RollDisplay roll;
+
+    static constexpr int maxPendingTriggers = 1024;
+    static constexpr double autoTimeoutSeconds = 0.1;
+    static constexpr double phosphorBudgetSeconds = 0.004;
+    static constexpr int maxSweepsPerFrame = 256;
+    static constexpr int maxOverlaidPhosphorLayers = 4; // beyond this, overlaid channels share one layer
+    static constexpr int minPeriodLockSpan = 2048, maxPeriodLockSpan = 1 << 18;
+    static constexpr int minViewSamples = 8;
+    static constexpr int maxReferences = 4;
+    static constexpr int differenceBlockSize = 4096;
+    static constexpr int maxDifferenceSamplesPerColumn = 256;  // beyond this, a column's samples are spread out
+    static constexpr int sincPointsPerColumn = 2;
+    static constexpr int maxGoniometerSamples = 32768;  // per pass; anything older is skipped
+    static constexpr double defaultGoniometerPersistence = 0.1;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ScopeRenderer)
+};
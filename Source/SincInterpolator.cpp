@@ -0,0 +1,75 @@
+/*
+  ==============================================================================
+
+    This file contains the sinc interpolator, which reconstructs the waveform
+    between samples for zoomed-in traces.
+
+  ==============================================================================
+*/
+
+#include "SincInterpolator.h"
+#include "VectorReductions.h"
+
+namespace
+{
+    // The zeroth order modified Bessel function, from its power series
+    double besselI0(double x)
+    {
+        double sum = 1.0, term = 1.0;
+
+        for (int k = 1; k < 50 && term > sum * 1.0e-12; ++k)
+        {
+            term *= juce::square(x * 0.5 / k);
+            sum += term;
+        }
+
+        return sum;
+    }
+}
+
+//==============================================================================
+SincInterpolator::SincInterpolator()
+{
+    static_assert(numTaps % 4 == 0, "a whole number of four-lane steps leaves no tail loop");
+
+    table.malloc((size_t) ((numPhases + 1) * numTaps));
+    const auto windowScale = 1.0 / besselI0(kaiserBeta);
+
+    for (int phase = 0; phase <= numPhases; ++phase)
+    {
+        auto* row = table + phase * numTaps;
+        const auto fraction = phase / (double) numPhases;
+        double sum = 0.0;
+
+        // Tap k weighs the sample at floor(index) - halfTaps + 1 + k
+        for (int k = 0; k < numTaps; ++k)
+        {
+            const auto distance = k - (halfTaps - 1) - fraction;
+            const auto x = juce::MathConstants<double>::pi * distance;
+            const auto sinc = std::abs(distance) < 1.0e-9 ? 1.0 : std::sin(x) / x;
+            const auto edge = juce::jlimit(0.0, 1.0, std::abs(distance) / halfTaps);
+            const auto window = besselI0(kaiserBeta * std::sqrt(1.0 - edge * edge)) * windowScale;
+
+            row[k] = (float) (sinc * window);
+            sum += row[k];
+        }
+
+        // Unity gain at DC, so a flat signal stays exactly flat
+        for (int k = 0; k < numTaps; ++k)
+            row[k] = (float) (row[k] / sum);
+    }
+}
+
+float SincInterpolator::getValue(const float* samples, double index) const
+{
+    const auto whole = std::floor(index);
+    const auto position = (index - whole) * numPhases;
+    const auto phase = juce::jlimit(0, numPhases - 1, (int) position);
+    const auto blend = (float) (position - phase);
+
+    const auto* first = samples + (int) whole - (halfTaps - 1);
+    const auto before = VectorReductions::dotProduct(getRow(phase), first, numTaps);
+    const auto after = VectorReductions::dotProduct(getRow(phase + 1), first, numTaps);
+
+    return before + (after - before) * blend;
+}
@@ -0,0 +1,100 @@
+/*
+  ==============================================================================
+
+    This file contains the scrolling spectrogram, which shows the spectrum of
+    the captured signal over time.
+
+  ==============================================================================
+*/
+
+#include "Spectrogram.h"
+
+//==============================================================================
+Spectrogram::Spectrogram()
+{
+    // Black through blue, purple, red and yellow to white as the level rises
+    const juce::Colour stops[] = { juce::Colours::black, juce::Colour(0xff1030a0), juce::Colour(0xff9020a0),
+                                   juce::Colour(0xffe03020), juce::Colour(0xfff0e040), juce::Colours::white };
+    const int numSegments = juce::numElementsInArray(stops) - 1;
+
+    palette.malloc((size_t) paletteSize);
+
+    for (int i = 0; i < paletteSize; ++i)
+    {
+        auto position = i * numSegments / (float) (paletteSize - 1);
+        auto segment = juce::jmin(numSegments - 1, (int) position);
+        palette[i] = stops[segment].interpolatedWith(stops[segment + 1], position - segment).getPixelARGB();
+    }
+}
+
+void Spectrogram::setSize(int newWidth, int newHeight)
+{
+    if (!ring.setSize(newWidth, newHeight))
+        return;
+
+    SpectrumAnalyser::mapBins(rows, ring.getHeight(), fftSize, sampleRate);
+    clear();
+}
+
+void Spectrogram::setFormat(int newFftSize, double newSampleRate, float newPowerScale)
+{
+    if (newFftSize == fftSize && newSampleRate == sampleRate && newPowerScale == powerScale)
+        return;
+
+    fftSize = newFftSize;
+    sampleRate = newSampleRate;
+    powerScale = newPowerScale;
+    SpectrumAnalyser::mapBins(rows, ring.getHeight(), fftSize, sampleRate);
+    clear();
+}
+
+void Spectrogram::clear()
+{
+    ring.clear(juce::Colours::black);
+}
+
+//==============================================================================
+void Spectrogram::addFrame(const float* power)
+{
+    const auto height = ring.getHeight();
+
+    if (!ring.isValid() || rows.size() != height)
+        return;
+
+    juce::Image::BitmapData data(ring.getImage(), juce::Image::BitmapData::writeOnly);
+    auto* pixel = data.getPixelPointer(ring.getWriteColumn(), height - 1);
+    const auto scale = (paletteSize - 1) / (SpectrumAnalyser::maxDecibels - SpectrumAnalyser::minDecibels);
+
+    // Bottom to top, so the lowest frequency ends up at the bottom
+    for (int row = 0; row < height; ++row, pixel -= data.lineStride)
+    {
+        auto level = SpectrumAnalyser::getLevel(power, rows.getReference(row), powerScale);
+        auto index = juce::jlimit(0, paletteSize - 1, (int) ((level - SpectrumAnalyser::minDecibels) * scale));
+        reinterpret_cast<juce::PixelARGB*>(pixel)->set(palette[index]);
+    }
+
+    ring.advance();
+}
+
+void Spectrogram::draw(juce::Graphics& g, int logicalWidth, int logicalHeight) const
+{
+    ring.draw(g, logicalWidth, logicalHeight);
+
+    if (!ring.isValid() || logicalWidth <= 0 || logicalHeight <= 0 || sampleRate <= 0.0)
+        return;
+
+    // Decade labels up the left edge
+    const auto logRange = std::log(sampleRate * 0.5 / SpectrumAnalyser::minFrequency);
+    g.setFont(11.0f);
+    g.setColour(juce::Colours::white.withAlpha(0.7f));
+
+    for (double frequency = 100.0; frequency < sampleRate * 0.5; frequency *= 10.0)
+    {
+        auto y = juce::roundToInt(logicalHeight * (1.0 - std::log(frequency / SpectrumAnalyser::minFrequency) / logRange));
+        auto text = frequency >= 1000.0 ? juce::String(juce::roundToInt(frequency / 1000.0)) + "k"
+                                        : juce::String(juce::roundToInt(frequency));
+
+        g.drawHorizontalLine(y, 0.0f, 6.0f);
+        g.drawText(text, 8, y - 7, 40, 14, juce::Justification::centredLeft);
+    }
+}
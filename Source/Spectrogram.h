@@ -0,0 +1,60 @@
+/*
+  ==============================================================================
+
+    This file contains the scrolling spectrogram, which shows the spectrum of
+    the captured signal over time.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "ColumnRing.h"
+#include "SpectrumAnalyser.h"
+
+//==============================================================================
+/**
+    A waterfall of FFT frames, newest on the right, frequency rising upwards on
+    a logarithmic axis.
+
+    The picture lives in a ColumnRing, and each frame writes one column of it.
+    A frame therefore costs one column of pixels however long the history on
+    screen is, which keeps hop rates of a few hundred frames a second cheap
+    even with several instances open.
+*/
+class Spectrogram
+{
+public:
+    Spectrogram();
+
+    /** Sets the size in physical pixels, one column per frame. Clears if it changed. */
+    void setSize(int width, int height);
+
+    /** Sets the analysis the frames will come from. Clears if it changed. */
+    void setFormat(int fftSize, double sampleRate, float powerScale);
+
+    int getWidth() const { return ring.getWidth(); }
+    int getHeight() const { return ring.getHeight(); }
+
+    /** Blanks the whole history. */
+    void clear();
+
+    /** Writes one frame's power spectrum as the newest column. */
+    void addFrame(const float* power);
+
+    /** Draws the history, oldest first, filling the given logical area. */
+    void draw(juce::Graphics& g, int logicalWidth, int logicalHeight) const;
+
+private:
+    static constexpr int paletteSize = 256;
+
+    ColumnRing ring;
+    juce::Array<SpectrumAnalyser::BinRange> rows; // bottom row first
+    juce::HeapBlock<juce::PixelARGB> palette;
+    int fftSize = 0;
+    double sampleRate = 0.0;
+    float powerScale = 1.0f;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(Spectrogram)
+};
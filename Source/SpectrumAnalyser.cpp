@@ -0,0 +1,226 @@
+/*
+  ==============================================================================
+
+    This file contains the spectrum analyser, which turns the captured signal
+    into an averaged, log-frequency magnitude spectrum.
+
+  ==============================================================================
+*/
+
+#include "SpectrumAnalyser.h"
+
+//==============================================================================
+void SpectrumAnalyser::setSettings(const Settings& newSettings, double newSampleRate)
+{
+    auto validated = newSettings;
+    validated.order = juce::jlimit(minOrder, maxOrder, validated.order);
+    validated.overlap = juce::jlimit(0.0f, 0.95f, validated.overlap);
+
+    const bool needsRestart = fft == nullptr || validated.order != settings.order
+                           || validated.window != settings.window || newSampleRate != sampleRate;
+    const bool peakHoldChanged = validated.peakHold != settings.peakHold;
+
+    settings = validated;
+    sampleRate = newSampleRate;
+
+    if (needsRestart)
+    {
+        const auto size = getSize();
+        const auto numBins = size / 2 + 1;
+
+        if (fft == nullptr || fft->getSize() != size)
+        {
+            fft = std::make_unique<juce::dsp::FFT>(settings.order);
+            window.malloc((size_t) size);
+            fftData.malloc((size_t) size * 2);
+            framePower.malloc((size_t) numBins);
+            averagePower.malloc((size_t) numBins);
+            peakPower.malloc((size_t) numBins);
+        }
+
+        using Windowing = juce::dsp::WindowingFunction<float>;
+        const Windowing::WindowingMethod methods[] = { Windowing::hann, Windowing::blackmanHarris,
+                                                       Windowing::flatTop, Windowing::rectangular };
+        Windowing::fillWindowingTables(window.get(), (size_t) size, methods[(int) settings.window], false);
+
+        // A full-scale sine peaks at half the window's sum in its bin
+        double windowSum = 0.0;
+
+        for (int i = 0; i < size; ++i)
+            windowSum += window[i];
+
+        powerScale = (float) juce::square(2.0 / juce::jmax(1.0e-9, windowSum));
+        reset();
+    }
+    else if (peakHoldChanged)
+    {
+        // Starting to hold again begins from the current spectrum
+        if (hasAverage)
+            juce::FloatVectorOperations::copy(peakPower.get(), averagePower.get(), getSize() / 2 + 1);
+    }
+}
+
+void SpectrumAnalyser::reset()
+{
+    nextFrameEnd = 0;
+    hasAverage = false;
+}
+
+//==============================================================================
+bool SpectrumAnalyser::process(const ScopeHistory& history, const int* channels, int numChannels)
+{
+    if (fft == nullptr || numChannels <= 0 || sampleRate <= 0.0)
+        return false;
+
+    const auto size = getSize();
+    const auto hop = (juce::int64) getHopSize();
+    const auto numBins = size / 2 + 1;
+
+    // Frames may only use samples every channel actually captured
+    auto validStart = history.getStartPosition();
+
+    for (int i = 0; i < numChannels; ++i)
+        validStart = juce::jmax(validStart, history.getValidStart(channels[i]));
+
+    auto roundUpToHop = [hop](juce::int64 position) { return (position + hop - 1) / hop * hop; };
+    auto frameEnd = juce::jmax(nextFrameEnd, roundUpToHop(validStart + size));
+    const auto lastFrameEnd = history.getEndPosition() / hop * hop;
+
+    if (frameEnd > lastFrameEnd)
+        return false;
+
+    // Far behind, e.g. after a freeze: the older frames would be averaged or
+    // scrolled away before they were seen anyway
+    frameEnd = juce::jmax(frameEnd, lastFrameEnd - (maxFramesPerCall - 1) * hop);
+
+    const auto coefficient = settings.averagingSeconds > 0.0
+                           ? (float) std::exp(-(double) hop / (sampleRate * settings.averagingSeconds))
+                           : 0.0f;
+
+    for (; frameEnd <= lastFrameEnd; frameEnd += hop)
+    {
+        juce::FloatVectorOperations::clear(framePower.get(), numBins);
+
+        for (int i = 0; i < numChannels; ++i)
+        {
+            history.forEachRun(channels[i], frameEnd - size, frameEnd, [&](const float* samples, int numSamples, juce::int64 position)
+            {
+                juce::FloatVectorOperations::multiply(fftData + (position - (frameEnd - size)), samples,
+                                                      window + (position - (frameEnd - size)), numSamples);
+            });
+
+            fft->performFrequencyOnlyForwardTransform(fftData.get(), true);
+
+            // Power, averaged over the channels
+            juce::FloatVectorOperations::multiply(fftData.get(), fftData.get(), numBins);
+            juce::FloatVectorOperations::addWithMultiply(framePower.get(), fftData.get(), 1.0f / (float) numChannels, numBins);
+        }
+
+        if (onFrame != nullptr)
+            onFrame(framePower.get(), numBins);
+
+        if (!hasAverage)
+        {
+            juce::FloatVectorOperations::copy(averagePower.get(), framePower.get(), numBins);
+            juce::FloatVectorOperations::copy(peakPower.get(), framePower.get(), numBins);
+            hasAverage = true;
+        }
+        else
+        {
+            juce::FloatVectorOperations::multiply(averagePower.get(), coefficient, numBins);
+            juce::FloatVectorOperations::addWithMultiply(averagePower.get(), framePower.get(), 1.0f - coefficient, numBins);
+        }
+
+        if (settings.peakHold)
+            juce::FloatVectorOperations::max(peakPower.get(), peakPower.get(), averagePower.get(), numBins);
+    }
+
+    nextFrameEnd = frameEnd;
+    return true;
+}
+
+//==============================================================================
+void SpectrumAnalyser::setDisplayWidth(int width)
+{
+    width = juce::jmax(1, width);
+
+    if (width == mappedWidth && getSize() == mappedSize && sampleRate == mappedSampleRate)
+        return;
+
+    mappedWidth = width;
+    mappedSize = getSize();
+    mappedSampleRate = sampleRate;
+    mapBins(columns, mappedWidth, mappedSize, mappedSampleRate);
+}
+
+void SpectrumAnalyser::mapBins(juce::Array<BinRange>& ranges, int numPixels, int fftSize, double sampleRate)
+{
+    ranges.clearQuick();
+
+    if (sampleRate <= 0.0 || numPixels <= 0)
+        return;
+
+    const auto lastBin = fftSize / 2;
+    const auto binsPerHertz = fftSize / sampleRate;
+    const auto range = std::log(sampleRate * 0.5 / minFrequency);
+
+    auto getBinPosition = [&](int x)
+    {
+        return minFrequency * std::exp(range * x / numPixels) * binsPerHertz;
+    };
+
+    for (int x = 0; x < numPixels; ++x)
+    {
+        auto from = getBinPosition(x);
+        auto to = getBinPosition(x + 1);
+        BinRange bins;
+
+        if (to - from >= 1.0)
+        {
+            // Several bins in one pixel: show the loudest, so narrow peaks survive
+            bins.first = juce::jlimit(1, lastBin, juce::roundToInt(from));
+            bins.last = juce::jlimit(bins.first, lastBin, juce::roundToInt(to) - 1);
+        }
+        else
+        {
+            // Low frequencies spread a bin over several pixels: interpolate
+            auto centre = juce::jlimit(1.0, (double) lastBin - 1.0, (from + to) * 0.5);
+            bins.first = (int) centre;
+            bins.fraction = (float) (centre - bins.first);
+            bins.interpolate = true;
+        }
+
+        ranges.add(bins);
+    }
+}
+
+float SpectrumAnalyser::getLevel(const float* power, const BinRange& bins, float powerScale)
+{
+    float value;
+
+    if (bins.interpolate)
+    {
+        value = power[bins.first] + bins.fraction * (power[bins.first + 1] - power[bins.first]);
+    }
+    else
+    {
+        value = power[bins.first];
+
+        for (int bin = bins.first + 1; bin <= bins.last; ++bin)
+            value = juce::jmax(value, power[bin]);
+    }
+
+    return juce::jmax(minDecibels, 10.0f * std::log10(value * powerScale + 1.0e-20f));
+}
+
+void SpectrumAnalyser::getColumnLevels(int column, float& average, float& peak) const
+{
+    average = peak = minDecibels;
+
+    if (!hasAverage || mappedSize != getSize() || !juce::isPositiveAndBelow(column, columns.size()))
+        return;
+
+    const auto& bins = columns.getReference(column);
+    average = getLevel(averagePower, bins, powerScale);
+    peak = settings.peakHold ? getLevel(peakPower, bins, powerScale) : average;
+}
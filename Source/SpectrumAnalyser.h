@@ -0,0 +1,136 @@
+/*
+  ==============================================================================
+
+    This file contains the spectrum analyser, which turns the captured signal
+    into an averaged, log-frequency magnitude spectrum.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "ScopeHistory.h"
+
+//==============================================================================
+/**
+    Windowed FFT analysis of the captured history.
+
+    process() is called by the thread that owns the ScopeHistory after each
+    drain, so the audio thread does no analysis at all. Frames end on a fixed
+    grid of hop-sized steps along the capture timeline, so the result does not
+    depend on how often the history is drained. The power of each frame is
+    averaged over the selected channels, smoothed exponentially and optionally
+    held at its peak.
+
+    The display reads one level per pixel column. Which bins each column
+    covers on the logarithmic frequency axis is worked out once per frame
+    size, width and sample rate, not per frame.
+*/
+class SpectrumAnalyser
+{
+public:
+    enum class Window
+    {
+        hann = 0,
+        blackmanHarris,
+        flatTop,
+        rectangular
+    };
+
+    struct Settings
+    {
+        int order = 12;                 // frames of 2^order samples
+        Window window = Window::hann;
+        float overlap = 0.5f;           // fraction of each frame shared with the next
+        double averagingSeconds = 0.0;  // exponential averaging time constant, 0 for none
+        bool peakHold = false;
+
+        bool operator== (const Settings& other) const
+        {
+            return order == other.order && window == other.window && overlap == other.overlap
+                && averagingSeconds == other.averagingSeconds && peakHold == other.peakHold;
+        }
+
+        bool operator!= (const Settings& other) const { return !operator== (other); }
+    };
+
+    static constexpr int minOrder = 10, maxOrder = 16;
+    static constexpr double minFrequency = 20.0;
+    static constexpr float minDecibels = -120.0f, maxDecibels = 0.0f;
+
+    /** Which bins a pixel covers on the logarithmic frequency axis. */
+    struct BinRange
+    {
+        int first = 0, last = 0;  // the loudest of these bins, when the pixel spans several
+        float fraction = 0.0f;    // otherwise, between first and first + 1
+        bool interpolate = false;
+    };
+
+    SpectrumAnalyser() = default;
+
+    /** Applies new settings. A new frame size, window or sample rate restarts
+        the analysis; this allocates, so it must not be called on the audio thread.
+    */
+    void setSettings(const Settings& newSettings, double newSampleRate);
+
+    /** Forgets the averaged and held spectra. */
+    void reset();
+
+    int getSize() const { return 1 << settings.order; }
+    int getHopSize() const { return juce::jmax(1, juce::roundToInt(getSize() * (1.0f - settings.overlap))); }
+
+    /** Analyses every frame completed since the last call for the given
+        channels, or only the most recent ones if it has fallen far behind.
+        Returns true if the spectrum changed.
+    */
+    bool process(const ScopeHistory& history, const int* channels, int numChannels);
+
+    /** True once at least one frame has been analysed. */
+    bool hasSpectrum() const { return hasAverage; }
+
+    /** Called by process() with the power of every frame analysed, before any
+        averaging, e.g. to feed a spectrogram. Set it before processing starts.
+    */
+    std::function<void(const float* power, int numBins)> onFrame;
+
+    /** Multiplies a bin's power to make a full-scale sine 0 dB. */
+    float getPowerScale() const { return powerScale; }
+
+    //==============================================================================
+    /** Maps the bins onto this many columns, if the mapping is not already current. */
+    void setDisplayWidth(int width);
+
+    /** Level of a column, in dB relative to a full-scale sine, for the averaged
+        and the held spectrum.
+    */
+    void getColumnLevels(int column, float& average, float& peak) const;
+
+    //==============================================================================
+    /** Fills ranges with numPixels entries spreading the bins of a frame of
+        fftSize samples from minFrequency to the Nyquist frequency.
+    */
+    static void mapBins(juce::Array<BinRange>& ranges, int numPixels, int fftSize, double sampleRate);
+
+    /** Level of one pixel's bins in dB, clamped to minDecibels. */
+    static float getLevel(const float* power, const BinRange& bins, float powerScale);
+
+private:
+    //==============================================================================
+    Settings settings;
+    double sampleRate = 0.0;
+
+    std::unique_ptr<juce::dsp::FFT> fft;
+    juce::HeapBlock<float> window, fftData, framePower, averagePower, peakPower;
+    float powerScale = 1.0f;  // makes a full-scale sine 0 dB
+    juce::int64 nextFrameEnd = 0;
+    bool hasAverage = false;
+
+    juce::Array<BinRange> columns;
+    int mappedWidth = 0, mappedSize = 0;
+    double mappedSampleRate = 0.0;
+
+    static constexpr int maxFramesPerCall = 64;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SpectrumAnalyser)
+};
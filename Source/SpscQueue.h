@@ -0,0 +1,83 @@
+/*
+  ==============================================================================
+
+    This file contains a small lock-free queue for passing events from the
+    audio thread to the display.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+    Fixed-capacity, wait-free single-producer / single-consumer queue of
+    trivially copyable items. A push into a full queue is dropped and counted
+    rather than waiting for the consumer.
+*/
+template <typename Item>
+class SpscQueue
+{
+public:
+    /** The capacity is rounded up to a power of two. */
+    explicit SpscQueue(int capacityToUse)
+        : capacity(juce::nextPowerOfTwo(juce::jmax(capacityToUse, 2))), mask(capacity - 1)
+    {
+        static_assert(std::is_trivially_copyable<Item>::value, "items are copied without constructors");
+        items.calloc((size_t) capacity);
+    }
+
+    /** Empties the queue. Neither side may be running while this is called. */
+    void reset()
+    {
+        writeIndex.store(0);
+        readIndex.store(0);
+        dropped.store(0);
+    }
+
+    /** Producer: returns false, and counts the item as dropped, if the queue is full. */
+    bool push(const Item& item)
+    {
+        const auto write = writeIndex.load(std::memory_order_relaxed);
+
+        if (write - readIndex.load(std::memory_order_acquire) >= (juce::uint64) capacity)
+        {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+
+        items[(size_t) (write & mask)] = item;
+        writeIndex.store(write + 1, std::memory_order_release);
+        return true;
+    }
+
+    /** Consumer: takes the oldest item, or returns false if there is none. */
+    bool pop(Item& item)
+    {
+        const auto read = readIndex.load(std::memory_order_relaxed);
+
+        if (read == writeIndex.load(std::memory_order_acquire))
+            return false;
+
+        item = items[(size_t) (read & mask)];
+        readIndex.store(read + 1, std::memory_order_release);
+        return true;
+    }
+
+    int getCapacity() const { return capacity; }
+    juce::uint64 getNumDropped() const { return dropped.load(std::memory_order_relaxed); }
+
+private:
+    juce::HeapBlock<Item> items;
+    const int capacity;
+    const juce::uint64 mask;
+
+    // Producer and consumer indices on separate cache lines
+    alignas(64) std::atomic<juce::uint64> writeIndex { 0 };
+    alignas(64) std::atomic<juce::uint64> readIndex { 0 };
+    alignas(64) std::atomic<juce::uint64> dropped { 0 };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SpscQueue)
+};
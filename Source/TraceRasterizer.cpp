@@ -0,0 +1,195 @@
+/*
+  ==============================================================================
+
+    This file contains the trace rasterizer, which draws waveforms straight
+    into pixel memory instead of building and stroking a Path.
+
+  ==============================================================================
+*/
+
+#include "TraceRasterizer.h"
+
+//==============================================================================
+void TraceColumns::setSize(int newWidth, int newHeight)
+{
+    newWidth = juce::jmax(1, newWidth);
+    newHeight = juce::jmax(1, newHeight);
+
+    if (newWidth != width)
+    {
+        tops.malloc((size_t) newWidth);
+        bottoms.malloc((size_t) newWidth);
+    }
+
+    width = newWidth;
+    height = newHeight;
+    clear();
+}
+
+void TraceColumns::clear()
+{
+    for (int x = 0; x < width; ++x)
+    {
+        tops[x] = std::numeric_limits<float>::max();
+        bottoms[x] = std::numeric_limits<float>::lowest();
+    }
+}
+
+void TraceColumns::addSpan(int column, float y1, float y2)
+{
+    if (!juce::isPositiveAndBelow(column, width))
+        return;
+
+    tops[column] = juce::jmin(tops[column], y1, y2);
+    bottoms[column] = juce::jmax(bottoms[column], y1, y2);
+}
+
+void TraceColumns::addLine(float x1, float y1, float x2, float y2)
+{
+    if (x2 < 0.0f || x1 >= (float) width)
+        return;
+
+    if (x2 - x1 < 1.0e-6f)
+    {
+        addSpan((int) std::floor(x1), y1, y2);
+        return;
+    }
+
+    auto slope = (y2 - y1) / (x2 - x1);
+    auto firstColumn = juce::jmax(0, (int) std::floor(x1));
+    auto lastColumn = juce::jmin(width - 1, (int) std::floor(x2));
+
+    // Each column takes the part of the segment that lies over it
+    for (int column = firstColumn; column <= lastColumn; ++column)
+    {
+        auto left = juce::jmax(x1, (float) column);
+        auto right = juce::jmin(x2, (float) (column + 1));
+        addSpan(column, y1 + (left - x1) * slope, y1 + (right - x1) * slope);
+    }
+}
+
+bool TraceColumns::getSpan(int column, float& top, float& bottom) const
+{
+    if (!isCovered(column))
+        return false;
+
+    top = tops[column];
+    bottom = bottoms[column];
+
+    for (auto neighbour : { column - 1, column + 1 })
+    {
+        if (isCovered(neighbour))
+        {
+            top = juce::jmin(top, 0.5f * (tops[column] + bottoms[neighbour]));
+            bottom = juce::jmax(bottom, 0.5f * (bottoms[column] + tops[neighbour]));
+        }
+    }
+
+    return finishSpan(top, bottom, height);
+}
+
+bool TraceColumns::finishSpan(float& top, float& bottom, int height)
+{
+    // At least a pixel thick, so flat stretches do not fade out
+    if (bottom - top < 1.0f)
+    {
+        auto centre = 0.5f * (top + bottom);
+        top = centre - 0.5f;
+        bottom = centre + 0.5f;
+    }
+
+    top = juce::jmax(top, 0.0f);
+    bottom = juce::jmin(bottom, (float) height);
+
+    return top < bottom;
+}
+
+//==============================================================================
+void TraceRasterizer::setSize(int newWidth, int newHeight)
+{
+    newWidth = juce::jmax(1, newWidth);
+    newHeight = juce::jmax(1, newHeight);
+
+    if (image.isValid() && newWidth == width && newHeight == height)
+        return;
+
+    width = newWidth;
+    height = newHeight;
+
+    // A software image, so BitmapData points straight at its pixels
+    image = juce::Image(juce::Image::ARGB, width, height, true, juce::SoftwareImageType());
+
+    dirtyStarts.calloc((size_t) width);
+    dirtyEnds.calloc((size_t) width);
+}
+
+void TraceRasterizer::clear()
+{
+    if (!image.isValid())
+        return;
+
+    juce::Image::BitmapData data(image, juce::Image::BitmapData::readWrite);
+
+    for (int x = 0; x < width; ++x)
+    {
+        auto* pixel = data.getPixelPointer(x, dirtyStarts[x]);
+
+        for (int y = dirtyStarts[x]; y < dirtyEnds[x]; ++y, pixel += data.lineStride)
+            reinterpret_cast<juce::PixelARGB*>(pixel)->setARGB(0, 0, 0, 0);
+
+        dirtyStarts[x] = dirtyEnds[x] = 0;
+    }
+}
+
+void TraceRasterizer::draw(const TraceColumns& trace, juce::Colour colour)
+{
+    if (!image.isValid())
+        return;
+
+    juce::Image::BitmapData data(image, juce::Image::BitmapData::readWrite);
+    const auto source = colour.getPixelARGB();
+    const auto numColumns = juce::jmin(width, trace.getWidth());
+
+    for (int x = 0; x < numColumns; ++x)
+    {
+        float top, bottom;
+
+        if (!trace.getSpan(x, top, bottom))
+            continue;
+
+        const auto rows = fillSpan(data, x, top, bottom, source);
+        const auto firstRow = rows.getStart(), endRow = rows.getEnd();
+
+        if (dirtyStarts[x] >= dirtyEnds[x])
+        {
+            dirtyStarts[x] = firstRow;
+            dirtyEnds[x] = endRow;
+        }
+        else
+        {
+            dirtyStarts[x] = juce::jmin(dirtyStarts[x], firstRow);
+            dirtyEnds[x] = juce::jmax(dirtyEnds[x], endRow);
+        }
+    }
+}
+
+juce::Range<int> TraceRasterizer::fillSpan(const juce::Image::BitmapData& data, int x, float top, float bottom, juce::PixelARGB colour)
+{
+    const auto firstRow = (int) top;
+    const auto endRow = juce::jmin(data.height, (int) std::ceil(bottom));
+    auto* pixel = data.getPixelPointer(x, firstRow);
+
+    // One blended pass, with fractional coverage at both ends
+    for (int y = firstRow; y < endRow; ++y, pixel += data.lineStride)
+    {
+        auto coverage = juce::jmin(bottom, (float) (y + 1)) - juce::jmax(top, (float) y);
+        auto blended = colour;
+
+        if (coverage < 1.0f)
+            blended.multiplyAlpha(coverage);
+
+        reinterpret_cast<juce::PixelARGB*>(pixel)->blend(blended);
+    }
+
+    return { firstRow, endRow };
+}
@@ -0,0 +1,107 @@
+/*
+  ==============================================================================
+
+    This file contains the trace rasterizer, which draws waveforms straight
+    into pixel memory instead of building and stroking a Path.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+    One trace described by the vertical extent it covers in each pixel column,
+    gathered with addSpan() for min/max envelopes or addLine() for
+    sample-to-sample segments. Both the TraceRasterizer and the phosphor display
+    draw from it, and neither needs a Path.
+*/
+class TraceColumns
+{
+public:
+    TraceColumns() = default;
+
+    /** Sets the size in physical pixels and clears. */
+    void setSize(int width, int height);
+
+    int getWidth() const { return width; }
+    int getHeight() const { return height; }
+
+    /** Leaves every column uncovered. */
+    void clear();
+
+    /** Extends a column to cover the pixel rows between y1 and y2. */
+    void addSpan(int column, float y1, float y2);
+
+    /** Extends the columns under a line segment, x1 <= x2, to cover it. */
+    void addLine(float x1, float y1, float x2, float y2);
+
+    /** Returns the rows to draw in a column: its extent reaching halfway to
+        each covered neighbour, so steep edges stay joined up, at least a pixel
+        thick, and clipped to the height. Returns false if there are none.
+    */
+    bool getSpan(int column, float& top, float& bottom) const;
+
+    /** Makes rows top to bottom at least a pixel thick and clips them to the
+        height, as getSpan() does. Returns false if nothing is left to draw.
+    */
+    static bool finishSpan(float& top, float& bottom, int height);
+
+private:
+    bool isCovered(int column) const
+    {
+        return juce::isPositiveAndBelow(column, width) && tops[column] <= bottoms[column];
+    }
+
+    juce::HeapBlock<float> tops, bottoms; // uncovered while top > bottom
+    int width = 0, height = 0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(TraceColumns)
+};
+
+//==============================================================================
+/**
+    Draws traces into a transparent software Image one pixel column at a time.
+
+    Each column's span is filled with a single blended pass down the column,
+    with fractional coverage at both ends for anti-aliasing. Nothing is
+    tessellated and nothing is allocated per frame.
+
+    Only the pixels drawn since the last clear() are cleared, so a frame costs
+    roughly the number of pixels the traces cover rather than the image size.
+*/
+class TraceRasterizer
+{
+public:
+    TraceRasterizer() = default;
+
+    /** Sets the size in physical pixels. Does nothing if it has not changed. */
+    void setSize(int width, int height);
+
+    int getWidth() const { return width; }
+    int getHeight() const { return height; }
+
+    /** Erases everything drawn so far. */
+    void clear();
+
+    /** Blends a trace into the image. */
+    void draw(const TraceColumns& trace, juce::Colour colour);
+
+    /** Blends colour down column x of a software image's pixels, over rows
+        top to bottom as finished by TraceColumns::finishSpan(), and returns
+        the rows written.
+    */
+    static juce::Range<int> fillSpan(const juce::Image::BitmapData& data, int x, float top, float bottom, juce::PixelARGB colour);
+
+    const juce::Image& getImage() const { return image; }
+
+private:
+    juce::Image image;
+    int width = 0, height = 0;
+
+    juce::HeapBlock<int> dirtyStarts, dirtyEnds; // rows written since the last clear()
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(TraceRasterizer)
+};
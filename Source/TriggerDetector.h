@@ -0,0 +1,160 @@
+/*
+  ==============================================================================
+
+    This file contains the level trigger used to find stable start points for
+    the displayed trace.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+    Streaming edge detector with slope selection, hysteresis and sub-sample
+    crossing times.
+
+    A rising trigger arms once the signal has been at or below
+    level - hysteresis and fires on the first sample above level; falling is
+    the mirror image. Because the state carries over between calls, a signal
+    can be fed in pieces of any size.
+
+    process() first takes the SIMD min/max of each short block and skips the
+    block entirely when those extremes show nothing could change state, so
+    most samples of a typical signal are never looked at one by one. Callers
+    that already know the extremes of a longer span (from a MinMaxPyramid)
+    can skip it the same way with canChangeState() and skip().
+*/
+class TriggerDetector
+{
+public:
+    enum class Slope
+    {
+        rising = 0,
+        falling,
+        both
+    };
+
+    TriggerDetector() = default;
+
+    void setLevel(float newLevel) { level = newLevel; }
+    void setHysteresis(float newHysteresis) { hysteresis = juce::jmax(0.0f, newHysteresis); }
+    void setSlope(Slope newSlope) { slope = newSlope; }
+
+    float getLevel() const { return level; }
+    float getHysteresis() const { return hysteresis; }
+    Slope getSlope() const { return slope; }
+
+    /** Disarms and forgets the previous sample. */
+    void reset()
+    {
+        armedRising = armedFalling = false;
+        hasPrevious = false;
+    }
+
+    /** Returns true if a span whose samples lie within [minimum, maximum] could
+        arm or fire the trigger. If not, the span can be passed over with skip().
+    */
+    bool canChangeState(float minimum, float maximum) const
+    {
+        if (slope != Slope::falling && (armedRising ? maximum > level : minimum <= level - hysteresis))
+            return true;
+
+        if (slope != Slope::rising && (armedFalling ? minimum < level : maximum >= level + hysteresis))
+            return true;
+
+        return false;
+    }
+
+    /** Passes over a span that canChangeState() ruled out, given its last sample. */
+    void skip(float lastSample)
+    {
+        previous = lastSample;
+        hasPrevious = true;
+    }
+
+    /** Feeds the next numSamples of the signal. For every trigger, calls
+        onTrigger (int index, float fraction, Slope edge), where the crossing lies
+        that fraction of the way from the sample before samples[index] to
+        samples[index]. For index 0, the sample before is the last one fed.
+    */
+    template <typename Callback>
+    void process(const float* samples, int numSamples, Callback&& onTrigger)
+    {
+        for (int blockStart = 0; blockStart < numSamples; blockStart += scanBlockSize)
+        {
+            const int blockEnd = juce::jmin(blockStart + scanBlockSize, numSamples);
+            float minimum, maximum;
+            juce::FloatVectorOperations::findMinAndMax(samples + blockStart, blockEnd - blockStart, minimum, maximum);
+
+            if (!canChangeState(minimum, maximum))
+            {
+                skip(samples[blockEnd - 1]);
+                continue;
+            }
+
+            for (int i = blockStart; i < blockEnd; ++i)
+                processSample(samples[i], i, onTrigger);
+        }
+    }
+
+private:
+    //==============================================================================
+    template <typename Callback>
+    void processSample(float sample, int index, Callback& onTrigger)
+    {
+        if (slope != Slope::falling)
+        {
+            if (armedRising && sample > level)
+            {
+                armedRising = false;
+                onTrigger(index, getCrossingFraction(sample), Slope::rising);
+            }
+            else if (sample <= level - hysteresis)
+            {
+                armedRising = true;
+            }
+        }
+
+        if (slope != Slope::rising)
+        {
+            if (armedFalling && sample < level)
+            {
+                armedFalling = false;
+                onTrigger(index, getCrossingFraction(sample), Slope::falling);
+            }
+            else if (sample >= level + hysteresis)
+            {
+                armedFalling = true;
+            }
+        }
+
+        previous = sample;
+        hasPrevious = true;
+    }
+
+    /** Linear interpolation of where the signal met the level between the
+        previous sample and this one. Only called on firing, when the previous
+        sample is on the other side of the level, so the two never coincide.
+    */
+    float getCrossingFraction(float sample) const
+    {
+        if (!hasPrevious)
+            return 0.0f;
+
+        return juce::jlimit(0.0f, 1.0f, (level - previous) / (sample - previous));
+    }
+
+    static constexpr int scanBlockSize = 32;
+
+    float level = 0.0f, hysteresis = 0.0f;
+    Slope slope = Slope::rising;
+
+    bool armedRising = false, armedFalling = false;
+    bool hasPrevious = false;
+    float previous = 0.0f;
+
+    JUCE_LEAK_DETECTOR(TriggerDetector)
+};
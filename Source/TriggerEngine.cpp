@@ -0,0 +1,67 @@
+/*
+  ==============================================================================
+
+    This file contains the audio-thread side of triggering: detection inside
+    processBlock, holdoff, and the queue of triggered frames for the display.
+
+  ==============================================================================
+*/
+
+#include "TriggerEngine.h"
+
+//==============================================================================
+void TriggerEngine::prepare(double newSampleRate)
+{
+    sampleRate = newSampleRate;
+    reset();
+}
+
+void TriggerEngine::reset()
+{
+    detector.reset();
+    events.reset();
+    holdoffEnd = 0;
+    firstTriggerInBlock = -1;
+}
+
+void TriggerEngine::process(const juce::AudioBuffer<float>& buffer, int numSamples, juce::int64 position)
+{
+    const auto channel = sourceChannel.load(std::memory_order_relaxed);
+    firstTriggerInBlock = -1;
+
+    if (!juce::isPositiveAndBelow(channel, buffer.getNumChannels()) || numSamples <= 0)
+        return;
+
+    detector.setLevel(level.load(std::memory_order_relaxed));
+    detector.setHysteresis(hysteresis.load(std::memory_order_relaxed));
+    detector.setSlope((TriggerDetector::Slope) slope.load(std::memory_order_relaxed));
+
+    const auto currentMode = (Mode) mode.load(std::memory_order_relaxed);
+    const auto holdoff = (juce::int64) std::round(holdoffSeconds.load(std::memory_order_relaxed) * sampleRate);
+    const auto ticks = juce::Time::getHighResolutionTicks();
+
+    detector.process(buffer.getReadPointer(channel), numSamples, [&](int index, float fraction, TriggerDetector::Slope edge)
+    {
+        const auto crossing = position + index - 1;
+
+        if (crossing < holdoffEnd)
+            return;
+
+        if (currentMode == Mode::single && !singleArmed.exchange(false))
+            return;
+
+        holdoffEnd = crossing + 1 + holdoff;
+        events.push({ crossing, fraction, edge, ticks });
+
+        if (firstTriggerInBlock < 0)
+            firstTriggerInBlock = index;
+
+        generation.fetch_add(1, std::memory_order_relaxed);
+    });
+}
+
+void TriggerEngine::skip()
+{
+    detector.reset();
+    firstTriggerInBlock = -1;
+}
@@ -0,0 +1,114 @@
+/*
+  ==============================================================================
+
+    This file contains the audio-thread side of triggering: detection inside
+    processBlock, holdoff, and the queue of triggered frames for the display.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "SpscQueue.h"
+#include "TriggerDetector.h"
+
+//==============================================================================
+/** One trigger found by the audio thread. */
+struct TriggerEvent
+{
+    juce::int64 position = 0;   // capture timeline position of the sample before the crossing
+    float fraction = 0.0f;      // how far past that sample the crossing lies
+    TriggerDetector::Slope edge = TriggerDetector::Slope::rising;
+    juce::int64 ticks = 0;      // Time::getHighResolutionTicks() of the block it was found in
+
+    /** The crossing as a fractional timeline position. */
+    double getTime() const { return (double) position + fraction; }
+};
+
+//==============================================================================
+/**
+    Runs a TriggerDetector over each block as it is captured, so every trigger
+    is seen once, in O(block) time, rather than searched for again by each
+    display frame. Accepted triggers are queued for the display.
+
+    Settings may be changed from any thread and take effect from the next block.
+*/
+class TriggerEngine
+{
+public:
+    enum class Mode
+    {
+        automatic = 0, // the display free-runs when no triggers arrive
+        normal,        // the display only updates on a trigger
+        single         // one trigger is accepted per armSingle()
+    };
+
+    TriggerEngine() = default;
+
+    void setLevel(float newLevel) { level.store(newLevel); }
+    void setHysteresis(float newHysteresis) { hysteresis.store(newHysteresis); }
+    void setSlope(TriggerDetector::Slope newSlope) { slope.store((int) newSlope); }
+    void setSourceChannel(int channel) { sourceChannel.store(channel); }
+    int getSourceChannel() const { return sourceChannel.load(); }
+    void setMode(Mode newMode) { mode.store((int) newMode); }
+    Mode getMode() const { return (Mode) mode.load(); }
+
+    /** After a trigger, further crossings are ignored for this long. Kept in
+        seconds, so it stays right when the sample rate changes.
+    */
+    void setHoldoff(double seconds) { holdoffSeconds.store(juce::jmax(0.0, seconds)); }
+
+    /** In single mode, lets the next trigger through. */
+    void armSingle() { singleArmed.store(true); }
+    bool isSingleArmed() const { return singleArmed.load(); }
+
+    /** Sets the sample rate and forgets all state and queued events. Neither
+        side may be running.
+    */
+    void prepare(double sampleRate);
+    void reset();
+
+    //==============================================================================
+    /** Audio thread: scans the block whose first sample is at the given
+        timeline position.
+    */
+    void process(const juce::AudioBuffer<float>& buffer, int numSamples, juce::int64 position);
+
+    /** Audio thread: passes over a block the capture had to drop. Its samples
+        never reach the history, so nothing in it may trigger, and the next
+        block's crossings are not measured from across the gap.
+    */
+    void skip();
+
+    /** Audio thread: the index of the first sample after the first trigger
+        accepted in the last block processed, or -1 if there was none.
+    */
+    int getFirstTriggerInBlock() const { return firstTriggerInBlock; }
+
+    //==============================================================================
+    /** Consumer: takes the oldest queued trigger, if any. */
+    bool pop(TriggerEvent& event) { return events.pop(event); }
+
+    juce::uint64 getNumDroppedEvents() const { return events.getNumDropped(); }
+
+    /** Counts accepted triggers, so any thread can tell whether a new one has arrived. */
+    juce::uint64 getGeneration() const { return generation.load(std::memory_order_relaxed); }
+
+private:
+    TriggerDetector detector;
+    SpscQueue<TriggerEvent> events { 1024 };
+    juce::int64 holdoffEnd = 0;
+    int firstTriggerInBlock = -1;
+    double sampleRate = 44100.0;
+
+    std::atomic<float> level { 0.0f }, hysteresis { 0.0f };
+    std::atomic<int> slope { (int) TriggerDetector::Slope::rising };
+    std::atomic<int> sourceChannel { 0 };
+    std::atomic<double> holdoffSeconds { 0.0 };
+    std::atomic<int> mode { (int) Mode::automatic };
+    std::atomic<bool> singleArmed { false };
+    std::atomic<juce::uint64> generation { 0 };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(TriggerEngine)
+};
@@ -0,0 +1,53 @@
+/*
+  ==============================================================================
+
+    This file contains the sums and dot products shared by the measurement
+    engine and the sinc interpolator.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+//==============================================================================
+/**
+    Reductions over float arrays that the compiler can vectorise.
+
+    A single running total makes every addition wait for the one before it,
+    and the compiler may not reorder floating point additions to break that
+    chain. Four independent accumulators break it in the source instead, so
+    the loops vectorise without reassociating anything, and the result is the
+    same whichever instructions the compiler picks.
+*/
+namespace VectorReductions
+{
+    inline float sum(const float* samples, int numSamples)
+    {
+        float lanes[4] = {};
+        int i = 0;
+
+        for (; i + 4 <= numSamples; i += 4)
+            for (int lane = 0; lane < 4; ++lane)
+                lanes[lane] += samples[i + lane];
+
+        for (; i < numSamples; ++i)
+            lanes[0] += samples[i];
+
+        return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+    }
+
+    inline float dotProduct(const float* a, const float* b, int numSamples)
+    {
+        float lanes[4] = {};
+        int i = 0;
+
+        for (; i + 4 <= numSamples; i += 4)
+            for (int lane = 0; lane < 4; ++lane)
+                lanes[lane] += a[i + lane] * b[i + lane];
+
+        for (; i < numSamples; ++i)
+            lanes[0] += a[i] * b[i];
+
+        return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+    }
+}